@@ -1,3 +1,4 @@
 #include <filesystem>
 
 extern const std::filesystem::path& SOURCE_ROOT;
+extern const std::filesystem::path& BINARY_ROOT;
@@ -0,0 +1,90 @@
+#include "animation.hpp"
+
+#include "error.hpp"
+
+#include <utility>
+
+namespace {
+
+size_t checkedFrameCount(int frames)
+{
+    check(frames > 0);
+    return static_cast<size_t>(frames);
+}
+
+} // namespace
+
+AnimationClip::AnimationClip(
+        SDL_Texture* texture, int w, int h, int frames, float framesPerSecond)
+    : _texture(texture)
+    , _width(w)
+    , _height(h)
+    , _frameCount(checkedFrameCount(frames))
+    , _framesPerSecond(framesPerSecond)
+    , _frames(Directions * Motions * _frameCount)
+{ }
+
+AnimationClip AnimationClip::strip(
+    SDL_Texture* texture,
+    const SDL_Rect& sheet,
+    int w,
+    int h,
+    int frames,
+    float framesPerSecond)
+{
+    auto clip = AnimationClip{texture, w, h, frames, framesPerSecond};
+    for (size_t i = 0; i < clip._frames.size(); i++) {
+        const int j = static_cast<int>(i % clip._frameCount);
+        clip._frames[i] =
+            SDL_Rect{.x = sheet.x + j * w, .y = sheet.y, .w = w, .h = h};
+    }
+    return clip;
+}
+
+AnimationClip AnimationClip::directional(
+    SDL_Texture* texture,
+    const SDL_Rect& sheet,
+    int w,
+    int h,
+    int frames,
+    float framesPerSecond)
+{
+    auto clip = AnimationClip{texture, w, h, frames, framesPerSecond};
+    int row = 0;
+    for (auto motion : {AnimatedMotion::Walk, AnimatedMotion::Stand}) {
+        for (auto direction : {
+                AnimatedDirection::Right,
+                AnimatedDirection::Left,
+                AnimatedDirection::Down,
+                AnimatedDirection::Up}) {
+            auto* rects = &clip._frames[
+                (static_cast<size_t>(direction) * Motions +
+                    static_cast<size_t>(motion)) * clip._frameCount];
+            for (int j = 0; j < frames; j++) {
+                rects[j] = SDL_Rect{
+                    .x = sheet.x + w * j, .y = sheet.y + h * row, .w = w, .h = h};
+            }
+            row++;
+        }
+    }
+    return clip;
+}
+
+const AnimationClip& AnimationLibrary::add(
+    const std::string& name, AnimationClip clip)
+{
+    auto [it, inserted] = _clips.try_emplace(name, std::move(clip));
+    if (!inserted) {
+        throw Error{} << "duplicate animation clip " << name;
+    }
+    return it->second;
+}
+
+const AnimationClip& AnimationLibrary::clip(const std::string& name) const
+{
+    auto it = _clips.find(name);
+    if (it == _clips.end()) {
+        throw Error{} << "no animation clip named " << name;
+    }
+    return it->second;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "sdl.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+enum class AnimatedDirection : uint8_t {Down, Up, Left, Right};
+enum class AnimatedMotion : uint8_t {Stand, Walk};
+
+// Frames of one animation on a sprite sheet, shared by all sprites that show
+// it. The frames are a flat table indexed by direction, motion and frame
+// number, in that order of significance.
+class AnimationClip {
+public:
+    static constexpr size_t Directions = 4;
+    static constexpr size_t Motions = 2;
+
+    // One row of frames, the same for every direction and motion
+    static AnimationClip strip(
+        SDL_Texture* texture,
+        const SDL_Rect& sheet,
+        int w,
+        int h,
+        int frames = 1,
+        float framesPerSecond = 3.f);
+
+    // A row of frames for each motion and direction. The sheet has the walk
+    // rows first, then the stand rows, each going right, left, down and up.
+    static AnimationClip directional(
+        SDL_Texture* texture,
+        const SDL_Rect& sheet,
+        int w,
+        int h,
+        int frames = 1,
+        float framesPerSecond = 3.f);
+
+    SDL_Texture* texture() const { return _texture; }
+    int width() const { return _width; }
+    int height() const { return _height; }
+    size_t frameCount() const { return _frameCount; }
+    float framesPerSecond() const { return _framesPerSecond; }
+
+    const SDL_Rect& frame(
+        AnimatedDirection direction, AnimatedMotion motion, size_t frame) const
+    {
+        return _frames[
+            (static_cast<size_t>(direction) * Motions +
+                static_cast<size_t>(motion)) * _frameCount + frame];
+    }
+
+private:
+    AnimationClip(
+        SDL_Texture* texture, int w, int h, int frames, float framesPerSecond);
+
+    SDL_Texture* _texture = nullptr;
+    int _width = 0;
+    int _height = 0;
+    size_t _frameCount = 0;
+    float _framesPerSecond = 0.f;
+    std::vector<SDL_Rect> _frames;
+};
+
+// Clips by name, built once when the sprite sheets are loaded. Clips never
+// move, so sprites keep plain pointers to them, and a name cannot be added
+// twice.
+class AnimationLibrary {
+public:
+    const AnimationClip& add(const std::string& name, AnimationClip clip);
+    const AnimationClip& clip(const std::string& name) const;
+
+private:
+    std::map<std::string, AnimationClip> _clips;
+};
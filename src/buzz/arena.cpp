@@ -0,0 +1,68 @@
+#include "arena.hpp"
+
+#include "error.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+Arena::Arena(size_t capacity)
+{
+    addBlock(std::max<size_t>(capacity, 1));
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    check(std::has_single_bit(alignment));
+
+    auto* block = &_blocks.back();
+    auto address = reinterpret_cast<uintptr_t>(block->memory.get()) + _offset;
+    auto padding = (alignment - address % alignment) % alignment;
+    if (_offset + padding + size > block->size) {
+        addBlock(std::max(block->size * 2, size + alignment));
+        block = &_blocks.back();
+        address = reinterpret_cast<uintptr_t>(block->memory.get());
+        padding = (alignment - address % alignment) % alignment;
+    }
+
+    _offset += padding;
+    void* result = block->memory.get() + _offset;
+    _offset += size;
+    _used += size;
+    return result;
+}
+
+void Arena::reset()
+{
+    if (_blocks.size() > 1) {
+        const auto total = capacity();
+        _blocks.clear();
+        addBlock(total);
+    }
+    _offset = 0;
+    _used = 0;
+}
+
+size_t Arena::capacity() const
+{
+    size_t total = 0;
+    for (const auto& block : _blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+void Arena::addBlock(size_t size)
+{
+    _blocks.push_back(Block{
+        .memory = std::make_unique_for_overwrite<std::byte[]>(size),
+        .size = size,
+    });
+    _offset = 0;
+}
+
+Arena& frameArena()
+{
+    thread_local Arena arena;
+    return arena;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Linear allocator for data that lives for one frame or tick. Allocation bumps
+// an offset, and nothing is freed until reset(), which drops everything at
+// once. A frame that outgrows the current block gets more blocks; the next
+// reset() replaces them with one block big enough for all of them, so a steady
+// workload stops going to the heap after a few frames.
+//
+// Not thread-safe: every thread has its own frameArena().
+class Arena {
+public:
+    explicit Arena(size_t capacity = 64 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    void reset();
+
+    // Bytes handed out since the last reset, and bytes held
+    size_t used() const { return _used; }
+    size_t capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size = 0;
+    };
+
+    void addBlock(size_t size);
+
+    std::vector<Block> _blocks;
+    size_t _offset = 0;
+    size_t _used = 0;
+};
+
+// The arena of the calling thread. Loops that own a thread reset it at the
+// top of every frame or tick: the main loops in main(), Simulation::run() and
+// the buzz-headless tick. Nothing allocated from it may outlive that.
+Arena& frameArena();
+
+// Standard allocator over an Arena; deallocation is a no-op. Default
+// constructed allocators use the frameArena() of the constructing thread.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept : _arena(&frameArena()) {}
+    explicit ArenaAllocator(Arena& arena) noexcept : _arena(&arena) {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : _arena(other.arena())
+    { }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    Arena* arena() const noexcept { return _arena; }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept
+    {
+        return _arena == other.arena();
+    }
+
+private:
+    Arena* _arena = nullptr;
+};
+
+template <class T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+using FrameString =
+    std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
@@ -0,0 +1,54 @@
+#include "asset-loader.hpp"
+
+#include <algorithm>
+
+AssetLoader::AssetLoader(int threads)
+{
+    for (int i = 0; i < std::max(threads, 1); i++) {
+        _workers.emplace_back([this] (std::stop_token stopToken) {
+            work(stopToken);
+        });
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    for (auto& worker : _workers) {
+        worker.request_stop();
+    }
+    _wake.notify_all();
+    _workers.clear();
+}
+
+ImageFuture AssetLoader::loadImage(const std::filesystem::path& path)
+{
+    return submit([path] {
+        auto loaded = SurfacePtr{sdlCheck(IMG_Load(path.c_str())), SDL_FreeSurface};
+        return SurfacePtr{
+            sdlCheck(SDL_ConvertSurfaceFormat(
+                loaded.get(), SDL_PIXELFORMAT_RGBA32, 0)),
+            SDL_FreeSurface};
+    });
+}
+
+int AssetLoader::defaultThreadCount()
+{
+    return std::clamp(
+        static_cast<int>(std::thread::hardware_concurrency()), 1, 8);
+}
+
+void AssetLoader::work(std::stop_token stopToken)
+{
+    for (;;) {
+        auto task = std::function<void()>{};
+        {
+            auto lock = std::unique_lock{_mutex};
+            if (!_wake.wait(lock, stopToken, [this] { return !_queue.empty(); })) {
+                return;
+            }
+            task = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        task();
+    }
+}
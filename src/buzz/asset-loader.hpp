@@ -0,0 +1,56 @@
+#pragma once
+
+#include "sdl.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using SurfacePtr = std::unique_ptr<SDL_Surface, void(*)(SDL_Surface*)>;
+using ImageFuture = std::future<SurfacePtr>;
+
+// Runs asset loading work on a pool of background threads. Images are
+// decoded into RGBA32 surfaces there; uploading them into textures is left to
+// the render thread. IMG_Init must be called before the first load.
+class AssetLoader {
+public:
+    explicit AssetLoader(int threads = defaultThreadCount());
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    ImageFuture loadImage(const std::filesystem::path& path);
+
+    template <class F>
+    auto submit(F&& function) -> std::future<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<F>(function));
+        auto future = task->get_future();
+        {
+            auto lock = std::scoped_lock{_mutex};
+            _queue.push_back([task] { (*task)(); });
+        }
+        _wake.notify_one();
+        return future;
+    }
+
+    static int defaultThreadCount();
+
+private:
+    void work(std::stop_token stopToken);
+
+    std::mutex _mutex;
+    std::condition_variable_any _wake;
+    std::deque<std::function<void()>> _queue;
+    std::vector<std::jthread> _workers;
+};
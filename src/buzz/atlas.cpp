@@ -0,0 +1,346 @@
+#include "atlas.hpp"
+
+#include "error.hpp"
+#include "mapped-file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int ManifestVersion = 1;
+constexpr int MaxPageSize = 2048;
+constexpr int Padding = 1;
+
+const char* ManifestFileName = "atlas.manifest";
+
+fs::path pageFileName(int index)
+{
+    return "page-" + std::to_string(index) + ".rgba";
+}
+
+// Pages are limited to what the renderer supports, so a cache packed for one
+// renderer may not fit another
+int pageSizeLimit(SDL_Renderer* renderer)
+{
+    int limit = MaxPageSize;
+    if (auto info = SDL_RendererInfo{};
+            SDL_GetRendererInfo(renderer, &info) == 0 &&
+            info.max_texture_width > 0 && info.max_texture_height > 0) {
+        limit = std::min(
+            {limit, info.max_texture_width, info.max_texture_height});
+    }
+    return limit;
+}
+
+} // namespace
+
+Atlas::Atlas(
+    AssetLoader& loader,
+    const fs::path& assetDirectory,
+    const fs::path& cacheDirectory)
+    : _cacheDirectory(cacheDirectory)
+    , _sources(scanSources(assetDirectory))
+{
+    if (loadCache(loader)) {
+        _loadedFromCache = true;
+        return;
+    }
+
+    for (const auto& source : _sources) {
+        _images.push_back(loader.loadImage(source.path));
+    }
+}
+
+void Atlas::upload(SDL_Renderer* renderer, AssetLoader& loader)
+{
+    const int maxPageSize = pageSizeLimit(renderer);
+    if (_loadedFromCache && maxPageSize != _maxPageSize) {
+        // Packed for another renderer: decode and pack again after all
+        _cachedPages.clear();
+        _cachedPageSizes.clear();
+        _regions.clear();
+        _loadedFromCache = false;
+        for (const auto& source : _sources) {
+            _images.push_back(loader.loadImage(source.path));
+        }
+    }
+    _maxPageSize = maxPageSize;
+
+    if (_loadedFromCache) {
+        for (size_t i = 0; i < _cachedPages.size(); i++) {
+            auto [w, h] = _cachedPageSizes[i];
+            auto file = _cachedPages[i].get();
+            addPage(renderer, w, h, file->data());
+        }
+        _cachedPages.clear();
+        return;
+    }
+
+    auto pages = std::vector<Page>{};
+    pack(pages);
+    for (const auto& page : pages) {
+        addPage(renderer, page.width, page.height, page.pixels.data());
+    }
+
+    try {
+        writeCache(pages);
+    } catch (const std::exception& e) {
+        std::cerr << "failed to write atlas cache: " << e.what() << "\n";
+    }
+}
+
+const AtlasRegion& Atlas::region(const std::string& name) const
+{
+    auto it = _regions.find(name);
+    if (it == _regions.end()) {
+        throw Error{} << "no sprite sheet named " << name << " in atlas";
+    }
+    return it->second;
+}
+
+SDL_Texture* Atlas::page(int index) const
+{
+    return _pages.at(index).raw();
+}
+
+SDL_Texture* Atlas::texture(const std::string& name) const
+{
+    return page(region(name).page);
+}
+
+std::vector<Atlas::Source> Atlas::scanSources(const fs::path& assetDirectory)
+{
+    auto sources = std::vector<Source>{};
+    for (const auto& entry : fs::directory_iterator{assetDirectory}) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".png") {
+            continue;
+        }
+        sources.push_back(Source{
+            .name = entry.path().stem().string(),
+            .path = entry.path(),
+            .size = entry.file_size(),
+            .modified = static_cast<long long>(
+                entry.last_write_time().time_since_epoch().count()),
+        });
+    }
+    std::sort(sources.begin(), sources.end(), [] (const auto& a, const auto& b) {
+        return a.name < b.name;
+    });
+    return sources;
+}
+
+bool Atlas::loadCache(AssetLoader& loader)
+{
+    auto manifest = std::ifstream{_cacheDirectory / ManifestFileName};
+    if (!manifest) {
+        return false;
+    }
+
+    std::string magic;
+    int version = 0;
+    if (!(manifest >> magic >> version) ||
+            magic != "buzz-atlas" || version != ManifestVersion) {
+        return false;
+    }
+
+    int cachedMaxPageSize = 0;
+    auto cachedSources = std::vector<Source>{};
+    auto pageSizes = std::vector<std::pair<int, int>>{};
+    auto regions = std::map<std::string, AtlasRegion>{};
+    for (std::string line; std::getline(manifest, line); ) {
+        auto stream = std::istringstream{line};
+        std::string kind;
+        if (!(stream >> kind)) {
+            continue;
+        }
+
+        if (kind == "max-page-size") {
+            stream >> cachedMaxPageSize;
+        } else if (kind == "source") {
+            auto& source = cachedSources.emplace_back();
+            stream >> source.name >> source.size >> source.modified;
+        } else if (kind == "page") {
+            int index = 0;
+            auto& [w, h] = pageSizes.emplace_back();
+            stream >> index >> w >> h;
+        } else if (kind == "region") {
+            std::string name;
+            auto region = AtlasRegion{};
+            stream >> name >> region.page >>
+                region.rect.x >> region.rect.y >> region.rect.w >> region.rect.h;
+            regions[name] = region;
+        }
+        if (stream.fail()) {
+            return false;
+        }
+    }
+
+    if (cachedSources != _sources) {
+        return false;
+    }
+
+    for (int i = 0; i < static_cast<int>(pageSizes.size()); i++) {
+        auto [w, h] = pageSizes[i];
+        std::error_code error;
+        if (fs::file_size(_cacheDirectory / pageFileName(i), error) !=
+                static_cast<uintmax_t>(w) * h * 4 || error) {
+            return false;
+        }
+    }
+
+    // Mapping is cheap, but faulting the pages in is not: touch them on the
+    // loader threads, so that the upload only copies resident memory
+    for (int i = 0; i < static_cast<int>(pageSizes.size()); i++) {
+        _cachedPages.push_back(
+            loader.submit([path = _cacheDirectory / pageFileName(i)] {
+                auto file = std::make_shared<MappedFile>(path);
+                file->prefault();
+                return file;
+            }));
+    }
+
+    _maxPageSize = cachedMaxPageSize;
+    _cachedPageSizes = std::move(pageSizes);
+    _regions = std::move(regions);
+    return true;
+}
+
+void Atlas::pack(std::vector<Page>& pages)
+{
+    auto surfaces = std::vector<SurfacePtr>{};
+    for (auto& image : _images) {
+        surfaces.push_back(image.get());
+    }
+    _images.clear();
+
+    // Shelf packing, tallest images first
+    auto order = std::vector<size_t>(_sources.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&surfaces] (auto a, auto b) {
+        return surfaces[a]->h > surfaces[b]->h;
+    });
+
+    struct Placement {
+        size_t source;
+        SDL_Rect rect;
+    };
+    auto placements = std::vector<std::vector<Placement>>(1);
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    for (auto i : order) {
+        int w = surfaces[i]->w;
+        int h = surfaces[i]->h;
+        check(w <= _maxPageSize && h <= _maxPageSize);
+
+        if (x + w > _maxPageSize) {
+            x = 0;
+            y += shelfHeight + Padding;
+            shelfHeight = 0;
+        }
+        if (y + h > _maxPageSize) {
+            placements.emplace_back();
+            x = 0;
+            y = 0;
+            shelfHeight = 0;
+        }
+
+        placements.back().push_back(Placement{
+            .source = i,
+            .rect = {.x = x, .y = y, .w = w, .h = h},
+        });
+        x += w + Padding;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+
+    for (const auto& pagePlacements : placements) {
+        if (pagePlacements.empty()) {
+            continue;
+        }
+
+        auto& page = pages.emplace_back();
+        for (const auto& placement : pagePlacements) {
+            page.width = std::max(page.width, placement.rect.x + placement.rect.w);
+            page.height = std::max(page.height, placement.rect.y + placement.rect.h);
+        }
+        page.pixels.assign(static_cast<size_t>(page.width) * page.height, 0);
+
+        for (const auto& placement : pagePlacements) {
+            auto* surface = surfaces[placement.source].get();
+            sdlCheck(SDL_LockSurface(surface));
+            for (int row = 0; row < placement.rect.h; row++) {
+                std::memcpy(
+                    page.pixels.data() +
+                        static_cast<size_t>(placement.rect.y + row) * page.width +
+                        placement.rect.x,
+                    static_cast<const uint8_t*>(surface->pixels) +
+                        static_cast<size_t>(row) * surface->pitch,
+                    static_cast<size_t>(placement.rect.w) * 4);
+            }
+            SDL_UnlockSurface(surface);
+
+            _regions[_sources[placement.source].name] = AtlasRegion{
+                .page = static_cast<int>(pages.size()) - 1,
+                .rect = placement.rect,
+            };
+        }
+    }
+}
+
+void Atlas::writeCache(const std::vector<Page>& pages) const
+{
+    fs::create_directories(_cacheDirectory);
+
+    // The manifest goes last, so an interrupted write leaves no valid cache
+    fs::remove(_cacheDirectory / ManifestFileName);
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        auto output = std::ofstream{
+            _cacheDirectory / pageFileName(static_cast<int>(i)),
+            std::ios::binary};
+        output.write(
+            reinterpret_cast<const char*>(pages[i].pixels.data()),
+            static_cast<std::streamsize>(pages[i].pixels.size() * 4));
+        check(output.good());
+    }
+
+    auto manifest = std::ofstream{_cacheDirectory / ManifestFileName};
+    manifest << "buzz-atlas " << ManifestVersion << "\n";
+    manifest << "max-page-size " << _maxPageSize << "\n";
+    for (const auto& source : _sources) {
+        manifest << "source " << source.name << " " << source.size << " " <<
+            source.modified << "\n";
+    }
+    for (size_t i = 0; i < pages.size(); i++) {
+        manifest << "page " << i << " " << pages[i].width << " " <<
+            pages[i].height << "\n";
+    }
+    for (const auto& [name, region] : _regions) {
+        manifest << "region " << name << " " << region.page << " " <<
+            region.rect.x << " " << region.rect.y << " " <<
+            region.rect.w << " " << region.rect.h << "\n";
+    }
+    check(manifest.good());
+}
+
+void Atlas::addPage(
+    SDL_Renderer* renderer, int width, int height, const void* pixels)
+{
+    auto& page = _pages.emplace_back(sdlCheck(SDL_CreateTexture(
+        renderer,
+        SDL_PIXELFORMAT_RGBA32,
+        SDL_TEXTUREACCESS_STATIC,
+        width,
+        height)));
+    sdlCheck(SDL_UpdateTexture(page.raw(), nullptr, pixels, width * 4));
+    sdlCheck(SDL_SetTextureBlendMode(page.raw(), SDL_BLENDMODE_BLEND));
+}
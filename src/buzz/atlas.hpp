@@ -0,0 +1,92 @@
+#pragma once
+
+#include "asset-loader.hpp"
+#include "mapped-file.hpp"
+#include "sdl.hpp"
+#include "texture.hpp"
+
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct AtlasRegion {
+    int page = 0;
+    SDL_Rect rect {};
+};
+
+// All PNG sprite sheets from a directory, packed into a few large textures.
+//
+// The packed pages are cached as raw RGBA pixel files next to a text manifest
+// that lists the source files with their sizes and modification times, and
+// the page size limit they were packed for. When the sources and the limit
+// are unchanged, pages are memory-mapped and uploaded directly, with no
+// packing and no PNG decoding.
+//
+// Loading is split in two. The constructor only needs the file system: it
+// queues PNG decoding or cache page mapping on the loader's threads and
+// returns right away. upload() waits for that work and creates the page
+// textures, so it must run on the render thread. If the renderer turns out to
+// need smaller pages than the cache has, upload() decodes the sources on the
+// loader after all.
+class Atlas {
+public:
+    Atlas() {}
+    Atlas(
+        AssetLoader& loader,
+        const std::filesystem::path& assetDirectory,
+        const std::filesystem::path& cacheDirectory);
+
+    void upload(SDL_Renderer* renderer, AssetLoader& loader);
+
+    // Regions are named after the source file, without the extension
+    const AtlasRegion& region(const std::string& name) const;
+    SDL_Texture* page(int index) const;
+    SDL_Texture* texture(const std::string& name) const;
+
+    bool loadedFromCache() const { return _loadedFromCache; }
+
+private:
+    struct Source {
+        std::string name;
+        std::filesystem::path path;
+        uintmax_t size = 0;
+        long long modified = 0;
+
+        bool operator==(const Source& other) const
+        {
+            return name == other.name && size == other.size &&
+                modified == other.modified;
+        }
+    };
+
+    struct Page {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> pixels;
+    };
+
+    static std::vector<Source> scanSources(
+        const std::filesystem::path& assetDirectory);
+
+    bool loadCache(AssetLoader& loader);
+    void pack(std::vector<Page>& pages);
+    void writeCache(const std::vector<Page>& pages) const;
+
+    void addPage(SDL_Renderer* renderer, int width, int height, const void* pixels);
+
+    std::filesystem::path _cacheDirectory;
+    std::vector<Source> _sources;
+    int _maxPageSize = 0;
+
+    // Pending work, consumed by upload()
+    std::vector<std::pair<int, int>> _cachedPageSizes;
+    std::vector<std::future<std::shared_ptr<MappedFile>>> _cachedPages;
+    std::vector<ImageFuture> _images;
+
+    std::vector<Texture> _pages;
+    std::map<std::string, AtlasRegion> _regions;
+    bool _loadedFromCache = false;
+};
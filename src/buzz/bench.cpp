@@ -0,0 +1,235 @@
+#include "camera.hpp"
+#include "capture.hpp"
+#include "events.hpp"
+#include "scene.hpp"
+#include "sdl.hpp"
+#include "spatial-hash.hpp"
+#include "static-grid.hpp"
+#include "world.hpp"
+
+#include "evening.hpp"
+#include "thing.hpp"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Run as `buzz-bench --reporter xml::out=bench.xml` (or the bench-report
+// target) to get results that can be compared between builds
+
+namespace {
+
+constexpr double TickDelta = 1.0 / 60;
+
+class EventCounter : public evening::Subscriber {
+public:
+    explicit EventCounter(evening::Channel& channel)
+    {
+        subscribe<Move>(channel, [this] (const Move&) { moves++; });
+        subscribe<Spawn>(channel, [this] (const Spawn&) { spawns++; });
+        subscribe<SpawnBatch>(channel, [this] (const SpawnBatch& batch) {
+            spawns += batch.spawns.size();
+        });
+    }
+
+    size_t moves = 0;
+    size_t spawns = 0;
+};
+
+std::vector<XYVector> randomVectors(size_t count, float extent)
+{
+    auto random = std::mt19937{1};
+    auto coordinate = std::uniform_real_distribution<float>{-extent, extent};
+    auto vectors = std::vector<XYVector>(count);
+    for (auto& v : vectors) {
+        v = {coordinate(random), coordinate(random)};
+    }
+    return vectors;
+}
+
+} // namespace
+
+TEST_CASE("World::update", "[world]")
+{
+    for (int movers : {100, 1'000, 10'000}) {
+        evening::Channel worldEvents;
+        evening::Channel controlEvents;
+        auto world = World{worldEvents, controlEvents};
+        world.initStressLevel(StressLevel{.obstacles = movers, .movers = movers});
+        worldEvents.deliver();
+
+        BENCHMARK("update, " + std::to_string(movers) + " movers") {
+            world.update(TickDelta);
+        };
+        BENCHMARK("update and publish, " + std::to_string(movers) + " movers") {
+            world.update(TickDelta);
+            world.publish();
+            worldEvents.deliver();
+        };
+    }
+}
+
+TEST_CASE("static collision queries", "[world]")
+{
+    constexpr float CellSize = 2.f;
+    const auto positions = randomVectors(100'000, 700.f);
+    const auto queries = randomVectors(10'000, 700.f);
+
+    thing::EntityManager ecs;
+    auto hash = SpatialHash{CellSize};
+    auto bodies = std::vector<StaticGrid::Body>{};
+    for (size_t i = 0; i < positions.size(); i++) {
+        const auto entity = ecs.createEntity();
+        hash.insert(entity, positions[i], 1.f);
+        bodies.push_back(StaticGrid::Body{
+            .entity = entity,
+            .order = i,
+            .position = positions[i],
+            .radius = 1.f,
+        });
+    }
+
+    BENCHMARK("bake 100000 bodies") {
+        return StaticGrid{bodies, CellSize}.size();
+    };
+
+    const auto grid = StaticGrid{bodies, CellSize};
+    const auto extent = XYVector{1.f, 1.f};
+    BENCHMARK("SpatialHash, 10000 queries") {
+        auto result = std::vector<SpatialHash::Handle>{};
+        size_t found = 0;
+        for (const auto& q : queries) {
+            hash.query(q - extent, q + extent, result);
+            found += result.size();
+        }
+        return found;
+    };
+    BENCHMARK("StaticGrid, 10000 queries") {
+        auto result = std::vector<uint32_t>{};
+        size_t found = 0;
+        for (const auto& q : queries) {
+            grid.query(q - extent, q + extent, result);
+            found += result.size();
+        }
+        return found;
+    };
+}
+
+TEST_CASE("evening::Channel", "[events]")
+{
+    constexpr int EventCount = 10'000;
+
+    evening::Channel channel;
+    auto counter = EventCounter{channel};
+    thing::EntityManager ecs;
+    const auto entity = ecs.createEntity();
+
+    BENCHMARK("push and deliver 10000 Move") {
+        for (int i = 0; i < EventCount; i++) {
+            channel.push(Move{
+                .entity = entity,
+                .location = {1.f * i, 0.f},
+                .velocity = {1.f, 0.f}});
+        }
+        channel.deliver();
+        return counter.moves;
+    };
+
+    BENCHMARK("push and deliver 10000 Spawn") {
+        for (int i = 0; i < EventCount; i++) {
+            channel.push(Spawn{
+                .entity = entity,
+                .objectType = ObjectType::Tree,
+                .location = {1.f * i, 0.f}});
+        }
+        channel.deliver();
+        return counter.spawns;
+    };
+
+    BENCHMARK("push and deliver a SpawnBatch of 10000") {
+        auto batch = SpawnBatch{};
+        batch.spawns.reserve(EventCount);
+        for (int i = 0; i < EventCount; i++) {
+            batch.spawns.push_back(Spawn{
+                .entity = entity,
+                .objectType = ObjectType::Tree,
+                .location = {1.f * i, 0.f}});
+        }
+        channel.push(std::move(batch));
+        channel.deliver();
+        return counter.spawns;
+    };
+}
+
+TEST_CASE("Camera::rect", "[render]")
+{
+    const auto camera = Camera{
+        .pixelsPerUnit = 8,
+        .scale = 10,
+        .screenSize = {1920, 1080},
+        .center = {3.f, -2.f},
+    };
+    const auto positions = randomVectors(100'000, 100.f);
+    auto rects = std::vector<SDL_FRect>(positions.size());
+
+    BENCHMARK("100000 rects") {
+        for (size_t i = 0; i < positions.size(); i++) {
+            rects[i] = camera.rect(positions[i], 16, 16);
+        }
+        return rects.back().x;
+    };
+}
+
+TEST_CASE("DirectionalSprite", "[render]")
+{
+    const auto clip = AnimationClip::directional(
+        nullptr, SDL_Rect{.x = 0, .y = 0, .w = 32, .h = 128}, 16, 16, 2);
+    auto sprite = DirectionalSprite{clip};
+    const auto velocities = randomVectors(1'000, 10.f);
+
+    BENCHMARK("velocity and frame, 1000 updates") {
+        const SDL_Rect* frame = nullptr;
+        for (const auto& velocity : velocities) {
+            sprite.velocity(velocity);
+            frame = sprite.frame();
+        }
+        return frame;
+    };
+}
+
+TEST_CASE("View::present", "[render]")
+{
+    // Must be set up before the first config() call
+    useOffscreenRendering();
+
+    evening::Channel worldEvents;
+    evening::Channel controlEvents;
+    auto view = View{worldEvents, controlEvents};
+    auto world = World{worldEvents, controlEvents};
+    world.initStressLevel(StressLevel{.obstacles = 2'000, .movers = 200});
+    worldEvents.deliver();
+
+    BENCHMARK("present, 2200 sprites") {
+        view.update(TickDelta);
+        view.present();
+    };
+
+    view.renderAtNativeResolution(true);
+    BENCHMARK("present at native resolution, 2200 sprites") {
+        view.update(TickDelta);
+        view.present();
+    };
+    view.renderAtNativeResolution(false);
+
+    BENCHMARK("update, publish and present, 2200 sprites") {
+        world.update(TickDelta);
+        world.publish();
+        worldEvents.deliver();
+        view.update(TickDelta);
+        view.present();
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "sdl.hpp"
+#include "types.hpp"
+
+#include <cmath>
+
+struct Camera {
+    SDL_FRect rect(const XYVector& position, int spriteWidth, int spriteHeight) const
+    {
+        return {
+            .x = (position.x - center.x) * pixelsPerUnit * scale + screenSize.x / 2.f - spriteWidth * scale / 2.f,
+            .y = (center.y - position.y) * pixelsPerUnit * scale + screenSize.y / 2.f - spriteHeight * scale / 2.f,
+            .w = 1.f * spriteWidth * scale,
+            .h = 1.f * spriteHeight * scale,
+        };
+    }
+
+    // Half size of the world area visible on screen, in world units
+    XYVector halfView() const
+    {
+        const float unitsPerPixel = 1.f / (pixelsPerUnit * scale);
+        return {
+            screenSize.x * unitsPerPixel / 2,
+            screenSize.y * unitsPerPixel / 2,
+        };
+    }
+
+    // The same camera, moved to the nearest whole screen pixel, so that
+    // things at whole-pixel world positions land on whole screen pixels
+    Camera snapped() const
+    {
+        const float pixels = 1.f * pixelsPerUnit * scale;
+        auto camera = *this;
+        camera.center = {
+            std::round(center.x * pixels) / pixels,
+            std::round(center.y * pixels) / pixels,
+        };
+        return camera;
+    }
+
+    int pixelsPerUnit = 0;
+    int scale = 0;
+    ScreenVector screenSize;
+    XYVector center;
+};
@@ -0,0 +1,82 @@
+#include "capture.hpp"
+
+#include "error.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+const uint8_t* row(SDL_Surface* image, int y)
+{
+    return static_cast<const uint8_t*>(image->pixels) + y * image->pitch;
+}
+
+} // namespace
+
+void useOffscreenRendering()
+{
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_setenv("BUZZ_SOFTWARE_RENDERER", "1", 1);
+    // There is no display to wait for
+    SDL_setenv("BUZZ_PACING", "uncapped", 0);
+}
+
+void writePng(SDL_Surface* image, const std::filesystem::path& path)
+{
+    sdlCheck(IMG_SavePNG(image, path.string().c_str()));
+}
+
+void writeRaw(SDL_Surface* image, const std::filesystem::path& path)
+{
+    check(image->format->format == SDL_PIXELFORMAT_RGBA32);
+    auto output = std::ofstream{path, std::ios::binary};
+    for (int y = 0; y < image->h; y++) {
+        output.write(
+            reinterpret_cast<const char*>(row(image, y)), image->w * 4);
+    }
+    check(output.good());
+}
+
+SurfacePtr readImage(const std::filesystem::path& path)
+{
+    auto loaded = SurfacePtr{
+        sdlCheck(IMG_Load(path.string().c_str())), SDL_FreeSurface};
+    return SurfacePtr{
+        sdlCheck(SDL_ConvertSurfaceFormat(
+            loaded.get(), SDL_PIXELFORMAT_RGBA32, 0)),
+        SDL_FreeSurface};
+}
+
+ImageDifference compareImages(
+    SDL_Surface* actual, SDL_Surface* expected, int tolerance)
+{
+    check(actual->format->format == SDL_PIXELFORMAT_RGBA32 &&
+        expected->format->format == SDL_PIXELFORMAT_RGBA32);
+
+    auto difference = ImageDifference{};
+    if (actual->w != expected->w || actual->h != expected->h) {
+        difference.sizeMismatch = true;
+        return difference;
+    }
+
+    for (int y = 0; y < actual->h; y++) {
+        const auto* a = row(actual, y);
+        const auto* e = row(expected, y);
+        for (int x = 0; x < actual->w * 4; x += 4) {
+            int pixelDifference = 0;
+            for (int c = 0; c < 4; c++) {
+                pixelDifference =
+                    std::max(pixelDifference, std::abs(a[x + c] - e[x + c]));
+            }
+            if (pixelDifference > tolerance) {
+                difference.differentPixels++;
+            }
+            difference.maxChannelDifference =
+                std::max(difference.maxChannelDifference, pixelDifference);
+        }
+    }
+    return difference;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "asset-loader.hpp"
+#include "sdl.hpp"
+
+#include <cstddef>
+#include <filesystem>
+
+// Makes View render with SDL's dummy video driver and the software renderer,
+// so frames can be captured on machines with no display. Must be called
+// before the first config() call.
+void useOffscreenRendering();
+
+// RGBA32 surfaces, as View::capture() returns them
+void writePng(SDL_Surface* image, const std::filesystem::path& path);
+// Rows of RGBA bytes, top to bottom, with no header or row padding
+void writeRaw(SDL_Surface* image, const std::filesystem::path& path);
+SurfacePtr readImage(const std::filesystem::path& path);
+
+struct ImageDifference {
+    bool sizeMismatch = false;
+    size_t differentPixels = 0; // with a channel off by more than tolerance
+    int maxChannelDifference = 0;
+};
+
+ImageDifference compareImages(
+    SDL_Surface* actual, SDL_Surface* expected, int tolerance);
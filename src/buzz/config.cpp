@@ -1,7 +1,67 @@
 #include "config.hpp"
 
+#include "build-info.hpp"
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+void override(bool& value, const char* variable)
+{
+    if (const char* s = std::getenv(variable)) {
+        value = std::string{s} != "0";
+    }
+}
+
+void override(std::string& value, const char* variable)
+{
+    if (const char* s = std::getenv(variable)) {
+        value = s;
+    }
+}
+
+void override(int& value, const char* variable)
+{
+    if (const char* s = std::getenv(variable)) {
+        value = std::stoi(s);
+    }
+}
+
+Config loadConfig()
+{
+    auto config = Config{};
+    config.level = (BINARY_ROOT / "levels" / "test.level").string();
+    override(config.level, "BUZZ_LEVEL");
+    override(config.windowWidth, "BUZZ_WINDOW_WIDTH");
+    override(config.windowHeight, "BUZZ_WINDOW_HEIGHT");
+    override(config.softwareRenderer, "BUZZ_SOFTWARE_RENDERER");
+    override(config.batchSprites, "BUZZ_BATCH_SPRITES");
+    override(config.nativeResolution, "BUZZ_NATIVE_RESOLUTION");
+    override(config.snapCamera, "BUZZ_SNAP_CAMERA");
+    override(config.aggregateRenderErrors, "BUZZ_AGGREGATE_RENDER_ERRORS");
+    override(config.pacing, "BUZZ_PACING");
+    override(config.frameRate, "BUZZ_FRAME_RATE");
+    override(config.tickRate, "BUZZ_TICK_RATE");
+    override(config.threadedSimulation, "BUZZ_THREADED_SIMULATION");
+    override(config.inputThread, "BUZZ_INPUT_THREAD");
+    override(config.simulationThreads, "BUZZ_SIMULATION_THREADS");
+    override(config.assetThreads, "BUZZ_ASSET_THREADS");
+    override(config.regionSize, "BUZZ_REGION_SIZE");
+    override(config.activeRegions, "BUZZ_ACTIVE_REGIONS");
+    override(config.reportStartup, "BUZZ_REPORT_STARTUP");
+    override(config.reportLatency, "BUZZ_REPORT_LATENCY");
+    override(config.profile, "BUZZ_PROFILE");
+    override(config.profilerOverlay, "BUZZ_PROFILER_OVERLAY");
+    override(config.recordInput, "BUZZ_RECORD_INPUT");
+    override(config.replayInput, "BUZZ_REPLAY_INPUT");
+    return config;
+}
+
+} // namespace
+
 const Config& config()
 {
-    static Config config;
+    static Config config = loadConfig();
     return config;
 }
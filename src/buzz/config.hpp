@@ -4,8 +4,31 @@
 
 struct Config {
     std::string windowTitle = "buzz";
+    std::string level; // the test level from the build tree by default
     int windowWidth = 1920;
     int windowHeight = 1080;
+    bool softwareRenderer = false;
+    bool batchSprites = true;
+    bool nativeResolution = false; // draw offscreen at 1x, then upscale once
+    bool snapCamera = false; // keep the camera on whole pixels
+    bool aggregateRenderErrors = true;
+    std::string pacing = "vsync"; // vsync, cap, uncapped or late
+    int frameRate = 0; // for cap and late; 0 uses the display refresh rate
+    int tickRate = 60; // simulation ticks per second; replays use their own
+    bool threadedSimulation = false;
+    bool inputThread = false; // implies threadedSimulation
+    int simulationThreads = 1;
+    int assetThreads = 0; // 0 picks a count from the hardware
+    int regionSize = 0; // world units per streamed region, 0 keeps all resident
+    int activeRegions = 2; // resident regions around the focus region
+    bool reportStartup = false;
+    bool reportLatency = false; // input-to-present latency, on exit
+    bool profile = false;
+    bool profilerOverlay = false;
+    std::string recordInput; // file to record control input to
+    std::string replayInput; // recording to play back instead of the keyboard
 };
 
+// Defaults can be overridden with BUZZ_* environment variables, e.g.
+// BUZZ_SOFTWARE_RENDERER=1 or BUZZ_BATCH_SPRITES=0
 const Config& config();
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "error.hpp"
+
+#include "thing.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Sparse set from entities to values. Lookup is a direct index by entity id
+// (thing hands ids out densely), values are kept packed in a contiguous array.
+// Erasing moves the last value into the freed slot, so iteration order is not
+// stable.
+template <class T>
+class EntityMap {
+public:
+    T* find(thing::Entity entity)
+    {
+        auto i = sparseIndex(entity);
+        if (i >= _sparse.size() || _sparse[i] == 0) {
+            return nullptr;
+        }
+        return &_values[_sparse[i] - 1];
+    }
+
+    const T* find(thing::Entity entity) const
+    {
+        return const_cast<EntityMap*>(this)->find(entity);
+    }
+
+    T& at(thing::Entity entity)
+    {
+        auto* value = find(entity);
+        check(value != nullptr);
+        return *value;
+    }
+
+    T& insert(thing::Entity entity, T value)
+    {
+        auto i = sparseIndex(entity);
+        if (i >= _sparse.size()) {
+            _sparse.resize(i + 1, 0);
+        }
+        if (_sparse[i] != 0) {
+            return _values[_sparse[i] - 1] = std::move(value);
+        }
+
+        _entities.push_back(entity);
+        _values.push_back(std::move(value));
+        _sparse[i] = static_cast<uint32_t>(_values.size());
+        return _values.back();
+    }
+
+    void erase(thing::Entity entity)
+    {
+        auto i = sparseIndex(entity);
+        if (i >= _sparse.size() || _sparse[i] == 0) {
+            return;
+        }
+
+        auto dense = _sparse[i] - 1;
+        if (dense + 1 != _values.size()) {
+            _values[dense] = std::move(_values.back());
+            _entities[dense] = _entities.back();
+            _sparse[sparseIndex(_entities[dense])] = dense + 1;
+        }
+        _values.pop_back();
+        _entities.pop_back();
+        _sparse[i] = 0;
+    }
+
+    // Room for this many values, so that inserting a batch does not
+    // reallocate the packed arrays
+    void reserve(size_t size)
+    {
+        _entities.reserve(size);
+        _values.reserve(size);
+    }
+
+    size_t size() const { return _values.size(); }
+    bool empty() const { return _values.empty(); }
+
+    const std::vector<thing::Entity>& entities() const { return _entities; }
+
+    auto begin() { return _values.begin(); }
+    auto end() { return _values.end(); }
+    auto begin() const { return _values.begin(); }
+    auto end() const { return _values.end(); }
+
+private:
+    static size_t sparseIndex(thing::Entity entity)
+    {
+        return static_cast<size_t>(entity.id());
+    }
+
+    std::vector<uint32_t> _sparse;
+    std::vector<thing::Entity> _entities;
+    std::vector<T> _values;
+};
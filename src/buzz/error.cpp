@@ -15,8 +15,12 @@ public:
     friend std::ostream& operator<<(
         std::ostream& output, const FormatLocation& fl)
     {
-        auto readablePath =
-            std::filesystem::proximate(fl._location.file_name(), SOURCE_ROOT);
+        std::error_code error;
+        auto readablePath = std::filesystem::proximate(
+            fl._location.file_name(), SOURCE_ROOT, error);
+        if (error) {
+            readablePath = fl._location.file_name();
+        }
         return output << readablePath.string() << ":" <<
             fl._location.line() << ":" << fl._location.column() << ":" <<
             " \"" << fl._location.function_name() << "\": ";
@@ -26,22 +30,56 @@ private:
     std::source_location _location;
 };
 
-std::string locationString(std::source_location location)
-{
-    auto stream = std::ostringstream{};
-    stream << FormatLocation{location};
-    return stream.str();
-}
-
 } // namespace
 
 Error::Error(std::source_location location)
-    : _message(locationString(location))
+    : _location(location)
+{ }
+
+Error::Error(const Error& other)
+    : std::exception(other)
+    , _location(other._location)
+    , _payload(other._payload)
+{ }
+
+Error::Error(Error&& other) noexcept
+    : std::exception(other)
+    , _location(other._location)
+    , _payload(std::move(other._payload))
 { }
 
-void check(bool condition, std::source_location location)
+Error& Error::operator=(const Error& other)
+{
+    _location = other._location;
+    _payload = other._payload;
+    _message.clear();
+    return *this;
+}
+
+Error& Error::operator=(Error&& other) noexcept
+{
+    _location = other._location;
+    _payload = std::move(other._payload);
+    _message.clear();
+    return *this;
+}
+
+const char* Error::what() const noexcept
 {
-    if (!condition) {
-        throw Error{std::move(location)};
+    try {
+        auto lock = std::scoped_lock{_mutex};
+        if (_message.empty()) {
+            auto stream = std::ostringstream{};
+            stream << FormatLocation{_location} << _payload;
+            _message = std::move(stream).str();
+        }
+        return _message.c_str();
+    } catch (...) {
+        return _payload.c_str();
     }
 }
+
+void throwCheckFailure(std::source_location location)
+{
+    throw Error{location};
+}
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <exception>
+#include <mutex>
 #include <ostream>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 #ifdef __clang__
     #include <experimental/source_location>
@@ -17,39 +21,68 @@
 template <class T>
 concept Streamable = requires (std::ostream& s, T x) { s << x; };
 
+// Keeps the location and the raw message; the readable text, with the path
+// relative to the source tree, is only put together when what() is called.
+// It is kept until the message grows, and is not shared between copies.
 class Error : public std::exception {
 public:
     Error(std::source_location location = std::source_location::current());
+    Error(const Error& other);
+    Error(Error&& other) noexcept;
+    Error& operator=(const Error& other);
+    Error& operator=(Error&& other) noexcept;
 
     template <Streamable T>
     Error& operator<<(T&& value) &
     {
-        updateMessage(std::forward<T>(value));
+        append(std::forward<T>(value));
         return *this;
     }
 
     template <Streamable T>
     Error&& operator<<(T&& value) &&
     {
-        updateMessage(std::forward<T>(value));
+        append(std::forward<T>(value));
         return std::move(*this);
     }
 
-    const char* what() const noexcept override
-    {
-        return _message.c_str();
-    }
+    const char* what() const noexcept override;
+
+    const std::source_location& location() const { return _location; }
+    const std::string& payload() const { return _payload; }
 
 private:
     template <Streamable T>
-    void updateMessage(T&& value)
+    void append(T&& value)
     {
-        auto stream = std::ostringstream{std::move(_message), std::ios::app};
-        stream << std::forward<T>(value);
-        _message = std::move(stream).str();
+        if constexpr (std::is_convertible_v<T, std::string_view>) {
+            _payload.append(std::string_view{value});
+        } else {
+            auto stream = std::ostringstream{};
+            stream << std::forward<T>(value);
+            _payload.append(std::move(stream).str());
+        }
+        _message.clear();
     }
 
-    std::string _message;
+    std::source_location _location;
+    std::string _payload;
+
+    // what() may be called from several threads, e.g. on an exception
+    // rethrown from a future
+    mutable std::mutex _mutex;
+    mutable std::string _message;
 };
 
-void check(bool condition, std::source_location location = std::source_location::current());
+// Failure paths are kept out of line, so that a passing check is only a
+// compare and a branch predicted not taken
+[[noreturn]] void throwCheckFailure(std::source_location location);
+
+inline void check(
+    bool condition,
+    std::source_location location = std::source_location::current())
+{
+    if (!condition) [[unlikely]] {
+        throwCheckFailure(location);
+    }
+}
@@ -6,6 +6,9 @@
 #include "thing.hpp"
 #include "ve.hpp"
 
+#include <cstdint>
+#include <vector>
+
 enum ObjectType {
     Hero,
     Tree,
@@ -17,8 +20,36 @@ struct Spawn {
     XYVector location;
 };
 
+// Objects that come into the world together, a level as it is loaded or a
+// region streamed back in, sent as one event
+struct SpawnBatch {
+    std::vector<Spawn> spawns;
+};
+
+// The entity is gone, e.g. with a region that was streamed out
+struct Despawn {
+    thing::Entity entity;
+};
+
+// The entity the world streams regions around, which the view follows
+struct Focus {
+    thing::Entity entity;
+};
+
 struct Move {
     thing::Entity entity;
     XYVector location;
     XYVector velocity;
 };
+
+// Follows the control state that a key event changed, with the SDL timestamp
+// of that event
+struct InputStamp {
+    uint32_t timestamp;
+};
+
+// A stamped control state has been applied by a tick, and the result
+// published with the Move events before this one
+struct InputApplied {
+    uint32_t timestamp;
+};
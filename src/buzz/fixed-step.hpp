@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+
+// Fixed-rate tick clock with bounded catch-up: after a stall, at most
+// maxCatchUpTicks are run and the rest of the lost time is dropped, so a
+// slow tick cannot make the simulation fall further and further behind.
+class FixedStep {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FixedStep(int ticksPerSecond, int maxCatchUpTicks)
+        : _tick(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>{1.0 / ticksPerSecond}))
+        , _maxCatchUpTicks(maxCatchUpTicks)
+        , _lastTickTime(Clock::now())
+    { }
+
+    // Start counting from now, e.g. after a long initialization
+    void reset()
+    {
+        _lastTickTime = Clock::now();
+    }
+
+    // Number of ticks that are due now
+    int operator()()
+    {
+        auto now = Clock::now();
+        auto ticks = static_cast<int>((now - _lastTickTime) / _tick);
+        if (ticks > _maxCatchUpTicks) {
+            _lastTickTime = now - _tick * _maxCatchUpTicks;
+            ticks = _maxCatchUpTicks;
+        }
+        _lastTickTime += _tick * ticks;
+        return ticks;
+    }
+
+    Clock::duration tickDuration() const
+    {
+        return _tick;
+    }
+
+    double delta() const
+    {
+        return std::chrono::duration<double>{_tick}.count();
+    }
+
+    Clock::time_point lastTickTime() const
+    {
+        return _lastTickTime;
+    }
+
+    Clock::time_point nextTickTime() const
+    {
+        return _lastTickTime + _tick;
+    }
+
+private:
+    Clock::duration _tick;
+    int _maxCatchUpTicks = 1;
+    Clock::time_point _lastTickTime;
+};
@@ -0,0 +1,93 @@
+#include "frame-pacer.hpp"
+
+#include "error.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+// Sleeps overshoot by up to a millisecond or two, so the end of a wait is
+// spun instead
+constexpr auto SpinTime = std::chrono::milliseconds{2};
+
+// Headroom left before the next refresh in PacingMode::LatePresent, for
+// frames slower than the estimate
+constexpr auto LateMargin = std::chrono::milliseconds{1};
+
+FramePacer::Clock::duration framePeriod(int frameRate)
+{
+    check(frameRate > 0);
+    return std::chrono::duration_cast<FramePacer::Clock::duration>(
+        std::chrono::duration<double>{1.0 / frameRate});
+}
+
+} // namespace
+
+PacingMode parsePacingMode(std::string_view name)
+{
+    if (name == "vsync") {
+        return PacingMode::Vsync;
+    } else if (name == "cap") {
+        return PacingMode::Cap;
+    } else if (name == "uncapped") {
+        return PacingMode::Uncapped;
+    } else if (name == "late") {
+        return PacingMode::LatePresent;
+    }
+    throw Error{} << "unknown pacing mode: " << name <<
+        " (expected vsync, cap, uncapped or late)";
+}
+
+bool presentsWithVsync(PacingMode mode)
+{
+    return mode == PacingMode::Vsync || mode == PacingMode::LatePresent;
+}
+
+FramePacer::FramePacer(PacingMode mode, int frameRate)
+    : _mode(mode)
+    , _period(framePeriod(frameRate))
+    , _nextFrame(Clock::now())
+    , _lastPresent(_nextFrame)
+{ }
+
+void FramePacer::beginFrame()
+{
+    if (_mode == PacingMode::Cap) {
+        waitUntil(_nextFrame);
+        // After a slow frame, start over from now instead of rushing frames
+        // out to catch up
+        const auto now = Clock::now();
+        _nextFrame = now - _nextFrame > _period ?
+            now + _period : _nextFrame + _period;
+    } else if (_mode == PacingMode::LatePresent) {
+        // The last present returned at about a refresh; start late enough
+        // to finish just before the next one
+        waitUntil(_lastPresent + _period - _workEstimate - LateMargin);
+    }
+    _frameStart = Clock::now();
+}
+
+void FramePacer::endFrame(Clock::time_point presentStart)
+{
+    _lastPresent = Clock::now();
+
+    // Rises at once with a slow frame, and decays slowly, so that one fast
+    // frame does not make the next one miss the refresh
+    const auto work = presentStart - _frameStart;
+    _workEstimate = work > _workEstimate ?
+        work : _workEstimate - (_workEstimate - work) / 16;
+    _workEstimate = std::min<Clock::duration>(_workEstimate, _period - LateMargin);
+}
+
+void FramePacer::waitUntil(Clock::time_point deadline)
+{
+    auto zone = ProfileZone{"FramePacer::wait"};
+    if (Clock::now() < deadline - SpinTime) {
+        std::this_thread::sleep_until(deadline - SpinTime);
+    }
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <string_view>
+
+enum class PacingMode {
+    Vsync, // present blocks until the display refreshes
+    Cap, // no vsync; frames are started at a fixed rate
+    Uncapped, // no vsync and no waiting, for benchmarking
+    LatePresent, // vsync, but each frame starts as late as it can and still
+                 // make the next refresh, so it shows fresher input
+};
+
+// Parses "vsync", "cap", "uncapped" or "late"
+PacingMode parsePacingMode(std::string_view name);
+
+bool presentsWithVsync(PacingMode mode);
+
+// Decides when the render loop starts its next frame. Waits sleep for most of
+// the time, and spin for the last stretch that the OS scheduler cannot hit
+// precisely.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // frameRate is the cap for PacingMode::Cap, and the display refresh rate
+    // for PacingMode::LatePresent
+    FramePacer(PacingMode mode, int frameRate);
+
+    PacingMode mode() const { return _mode; }
+
+    // Call before reading input for a frame
+    void beginFrame();
+
+    // Call right after the frame is presented, with the time the present
+    // call was made. Time spent blocked in it does not count as frame work.
+    void endFrame(Clock::time_point presentStart);
+
+private:
+    void waitUntil(Clock::time_point deadline);
+
+    PacingMode _mode = PacingMode::Vsync;
+    Clock::duration _period;
+    Clock::time_point _nextFrame;
+    Clock::time_point _frameStart;
+    Clock::time_point _lastPresent;
+    Clock::duration _workEstimate {};
+};
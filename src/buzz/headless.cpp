@@ -0,0 +1,305 @@
+#include "arena.hpp"
+#include "error.hpp"
+#include "events.hpp"
+#include "input-log.hpp"
+#include "kinematics.hpp"
+#include "profiler.hpp"
+#include "world.hpp"
+
+#include "evening.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Counted by the replaced global operator new, to check that ticks do not go
+// to the heap once warmed up
+std::atomic<uint64_t> heapAllocations {0};
+
+struct Options {
+    StressLevel level;
+    int ticks = 10'000;
+    int warmupTicks = 100;
+    int tickRate = 60;
+    int threads = 1;
+    RegionStreaming streaming;
+    std::string levelPath;
+    std::string tracePath;
+    std::string recordPath;
+    std::string replayPath;
+    bool realtime = false;
+};
+
+void printUsage(std::ostream& output)
+{
+    output <<
+        "usage: buzz-headless [options]\n"
+        "  --obstacles N    static obstacles in the level (default 1000)\n"
+        "  --movers N       moving objects in the level (default 10)\n"
+        "  --controlled     movers follow a scripted control input\n"
+        "  --random         movers wander randomly (default)\n"
+        "  --seed N         level generation seed (default 1)\n"
+        "  --level FILE     load a level file instead of generating one\n"
+        "  --ticks N        measured simulation ticks (default 10000)\n"
+        "  --warmup N       unmeasured ticks before measuring (default 100)\n"
+        "  --tick-rate N    simulated ticks per second (default 60)\n"
+        "  --threads N      simulation threads (default 1)\n"
+        "  --region-size N  stream the level in regions of N units\n"
+        "  --active-regions N\n"
+        "                   regions kept resident around the focus region\n"
+        "                   in each direction (default 2)\n"
+        "  --trace FILE     write a Chrome trace of the measured ticks\n"
+        "  --record FILE    record control input and checksums\n"
+        "  --replay FILE    replay a recording, checking every tick; the\n"
+        "                   level, tick rate and threads come from the file\n"
+        "  --realtime       run ticks at the tick rate instead of flat out\n";
+}
+
+Options parseOptions(int argc, char* argv[])
+{
+    auto options = Options{};
+    for (int i = 1; i < argc; i++) {
+        auto arg = std::string_view{argv[i]};
+        auto string = [&] {
+            if (i + 1 >= argc) {
+                throw Error{} << "missing value for " << arg;
+            }
+            return std::string{argv[++i]};
+        };
+        auto value = [&] {
+            return std::stoi(string());
+        };
+
+        if (arg == "--obstacles") {
+            options.level.obstacles = value();
+        } else if (arg == "--movers") {
+            options.level.movers = value();
+        } else if (arg == "--controlled") {
+            options.level.randomMovers = false;
+        } else if (arg == "--random") {
+            options.level.randomMovers = true;
+        } else if (arg == "--seed") {
+            options.level.seed = value();
+        } else if (arg == "--ticks") {
+            options.ticks = value();
+        } else if (arg == "--warmup") {
+            options.warmupTicks = value();
+        } else if (arg == "--tick-rate") {
+            options.tickRate = value();
+        } else if (arg == "--threads") {
+            options.threads = value();
+        } else if (arg == "--region-size") {
+            options.streaming.regionSize = static_cast<float>(value());
+        } else if (arg == "--active-regions") {
+            options.streaming.activeRadius = value();
+        } else if (arg == "--level") {
+            options.levelPath = string();
+        } else if (arg == "--trace") {
+            options.tracePath = string();
+        } else if (arg == "--record") {
+            options.recordPath = string();
+        } else if (arg == "--replay") {
+            options.replayPath = string();
+        } else if (arg == "--realtime") {
+            options.realtime = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(std::cout);
+            std::exit(0);
+        } else {
+            printUsage(std::cerr);
+            throw Error{} << "unknown option: " << arg;
+        }
+    }
+
+    check(options.ticks > 0 && options.warmupTicks >= 0 &&
+        options.tickRate > 0 && options.threads > 0 &&
+        options.streaming.regionSize >= 0 && options.streaming.activeRadius >= 0);
+    return options;
+}
+
+// Scripted input for controlled movers: walk in a circle, with pauses
+XYVector scriptedControl(int tick, int tickRate)
+{
+    static const XYVector directions[] {
+        {1, 0}, {1, 1}, {0, 1}, {-1, 1},
+        {-1, 0}, {-1, -1}, {0, -1}, {1, -1},
+        {0, 0},
+    };
+    return directions[(tick / tickRate) % std::size(directions)];
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    auto index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted.at(index);
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main(int argc, char* argv[]) try
+{
+    auto options = parseOptions(argc, argv);
+
+    auto replay = std::unique_ptr<InputReplay>{};
+    auto session = SessionInfo{
+        .tickRate = options.tickRate,
+        .threads = options.threads,
+        .streaming = options.streaming,
+        .level = options.levelPath,
+    };
+    if (options.levelPath.empty()) {
+        session.stressLevel = options.level;
+    }
+    if (!options.replayPath.empty()) {
+        replay = std::make_unique<InputReplay>(options.replayPath);
+        session = replay->session();
+        check(session.tickRate > 0 && session.threads > 0);
+        options.tickRate = session.tickRate;
+        options.threads = session.threads;
+        options.warmupTicks = 0;
+        options.ticks = static_cast<int>(replay->ticks());
+        check(options.ticks > 0);
+    }
+    const double delta = 1.0 / options.tickRate;
+
+    evening::Channel worldEvents;
+    evening::Channel controlEvents;
+
+    auto world = World{worldEvents, controlEvents};
+    const auto loadStart = Clock::now();
+    initLevel(world, session);
+    const auto loadTime = std::chrono::duration<double, std::milli>(
+        Clock::now() - loadStart).count();
+    worldEvents.deliver();
+
+    // Movers in level files take scripted control if they are controlled
+    const bool scripted =
+        !session.stressLevel || !session.stressLevel->randomMovers;
+
+    auto recorder = std::unique_ptr<InputRecorder>{};
+    if (!options.recordPath.empty()) {
+        recorder = std::make_unique<InputRecorder>(options.recordPath, session);
+        world.record(recorder.get());
+    }
+
+    auto tick = [&] (int i) {
+        frameArena().reset();
+        if (replay) {
+            replay->feed(world.tick(), controlEvents);
+            controlEvents.deliver();
+        } else if (scripted && i % options.tickRate == 0) {
+            controlEvents.push(scriptedControl(i, options.tickRate));
+            controlEvents.deliver();
+        }
+        world.update(delta);
+        if (replay) {
+            replay->verify(world.tick(), world.checksum());
+        }
+        world.publish();
+        worldEvents.deliver();
+    };
+
+    for (int i = 0; i < options.warmupTicks; i++) {
+        tick(i);
+    }
+
+    setProfileThreadName("main");
+    enableProfiling(!options.tracePath.empty());
+
+    auto latencies = std::vector<double>(options.ticks);
+    const auto allocationsBefore = heapAllocations.load();
+    const auto start = Clock::now();
+    for (int i = 0; i < options.ticks; i++) {
+        if (options.realtime) {
+            std::this_thread::sleep_until(
+                start + std::chrono::duration<double>{i * delta});
+        }
+        const auto tickStart = Clock::now();
+        tick(options.warmupTicks + i);
+        latencies[i] = std::chrono::duration<double, std::micro>(
+            Clock::now() - tickStart).count();
+    }
+    const auto total =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    const auto allocations = heapAllocations.load() - allocationsBefore;
+
+    std::sort(latencies.begin(), latencies.end());
+
+    if (!options.tracePath.empty()) {
+        auto records = std::vector<ProfileRecord>{};
+        captureProfile(records);
+        auto output = std::ofstream{options.tracePath};
+        writeChromeTrace(output, records);
+        check(output.good());
+    }
+
+    if (const auto& level = session.stressLevel) {
+        std::cout <<
+            "obstacles: " << level->obstacles << "\n" <<
+            "movers: " << level->movers <<
+                (level->randomMovers ? " (random)" : " (controlled)") << "\n";
+    } else {
+        std::cout << "level: " << session.level << "\n";
+    }
+    std::cout <<
+        "level load: " << loadTime << " ms\n" <<
+        "threads: " << options.threads << "\n" <<
+        "resident objects: " << world.residentObjects() <<
+            " (" << world.storedRegions() << " regions stored)\n" <<
+        "integration kernel: " << kernelIsaName(kernelIsa()) << "\n" <<
+        "ticks: " << options.ticks << "\n" <<
+        "total time: " << total << " s\n" <<
+        "ticks/sec: " << options.ticks / total << "\n" <<
+        "tick latency, us: " <<
+            "p50 " << percentile(latencies, 0.5) <<
+            ", p90 " << percentile(latencies, 0.9) <<
+            ", p99 " << percentile(latencies, 0.99) <<
+            ", max " << latencies.back() << "\n" <<
+        "heap allocations/tick: " <<
+            static_cast<double>(allocations) / options.ticks << "\n";
+
+    if (replay) {
+        std::cout << "verified ticks: " << replay->verifiedTicks() << "\n";
+        if (auto tick = replay->firstMismatch()) {
+            std::cerr << "replay diverged from the recording at tick " <<
+                *tick << "\n";
+            return 1;
+        }
+    }
+} catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+}
@@ -0,0 +1,223 @@
+#include "input-log.hpp"
+
+#include "error.hpp"
+
+#include "build-info.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+static_assert(std::endian::native == std::endian::little);
+
+constexpr std::array<char, 4> Magic {'B', 'Z', 'I', 'N'};
+// Version 1 has no level file path, version 2 adds it, and version 3 adds
+// region streaming
+constexpr uint32_t Version = 3;
+
+constexpr uint8_t ControlKind = 1;
+constexpr uint8_t ChecksumKind = 2;
+
+template <class T>
+void write(std::ostream& output, const T& value)
+{
+    output.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeVarint(std::ostream& output, uint64_t value)
+{
+    while (value >= 0x80) {
+        output.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    output.put(static_cast<char>(value));
+}
+
+class Reader {
+public:
+    explicit Reader(const fs::path& path)
+    {
+        auto input = std::ifstream{path, std::ios::binary};
+        if (!input) {
+            throw Error{} << "cannot open input log " << path.string();
+        }
+        _data.assign(
+            std::istreambuf_iterator<char>{input},
+            std::istreambuf_iterator<char>{});
+    }
+
+    bool done() const { return _position == _data.size(); }
+
+    template <class T>
+    T read()
+    {
+        check(_position + sizeof(T) <= _data.size());
+        T value;
+        std::memcpy(&value, _data.data() + _position, sizeof(T));
+        _position += sizeof(T);
+        return value;
+    }
+
+    uint64_t readVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            check(shift < 64);
+            auto byte = read<uint8_t>();
+            value |= uint64_t{byte & 0x7fu} << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+    }
+
+private:
+    std::vector<char> _data;
+    size_t _position = 0;
+};
+
+} // namespace
+
+void initLevel(World& world, const SessionInfo& session)
+{
+    world.setThreads(session.threads);
+    world.streamRegions(session.streaming);
+    if (session.stressLevel) {
+        world.initStressLevel(*session.stressLevel);
+    } else {
+        world.loadLevel(LevelFile{session.level});
+    }
+}
+
+InputRecorder::InputRecorder(const fs::path& path, const SessionInfo& session)
+    : _output(path, std::ios::binary)
+{
+    if (!_output) {
+        throw Error{} << "cannot create input log " << path.string();
+    }
+
+    _output.write(Magic.data(), Magic.size());
+    write(_output, Version);
+    write(_output, static_cast<int32_t>(session.tickRate));
+    write(_output, static_cast<int32_t>(session.threads));
+    write(_output, session.streaming.regionSize);
+    write(_output, static_cast<int32_t>(session.streaming.activeRadius));
+    write(_output, static_cast<uint8_t>(session.stressLevel.has_value()));
+    const auto level = session.stressLevel.value_or(StressLevel{});
+    write(_output, static_cast<int32_t>(level.obstacles));
+    write(_output, static_cast<int32_t>(level.movers));
+    write(_output, static_cast<uint8_t>(level.randomMovers));
+    write(_output, level.obstacleDensity);
+    write(_output, static_cast<uint32_t>(level.seed));
+    write(_output, static_cast<uint32_t>(session.level.size()));
+    _output.write(session.level.data(), session.level.size());
+}
+
+void InputRecorder::control(uint64_t tick, const XYVector& control)
+{
+    entry(ControlKind, tick);
+    write(_output, control.x);
+    write(_output, control.y);
+}
+
+void InputRecorder::checksum(uint64_t tick, uint64_t checksum)
+{
+    entry(ChecksumKind, tick);
+    write(_output, checksum);
+}
+
+void InputRecorder::entry(uint8_t kind, uint64_t tick)
+{
+    check(tick >= _lastTick);
+    _output.put(static_cast<char>(kind));
+    writeVarint(_output, tick - _lastTick);
+    _lastTick = tick;
+}
+
+InputReplay::InputReplay(const fs::path& path)
+{
+    auto reader = Reader{path};
+
+    auto magic = std::array<char, 4>{};
+    for (auto& c : magic) {
+        c = reader.read<char>();
+    }
+    const auto version = reader.read<uint32_t>();
+    if (magic != Magic || version < 1 || version > Version) {
+        throw Error{} << path.string() << " is not a buzz input log";
+    }
+
+    _session.tickRate = reader.read<int32_t>();
+    _session.threads = reader.read<int32_t>();
+    if (version >= 3) {
+        _session.streaming.regionSize = reader.read<float>();
+        _session.streaming.activeRadius = reader.read<int32_t>();
+    }
+    const bool stress = reader.read<uint8_t>();
+    auto level = StressLevel{};
+    level.obstacles = reader.read<int32_t>();
+    level.movers = reader.read<int32_t>();
+    level.randomMovers = reader.read<uint8_t>();
+    level.obstacleDensity = reader.read<float>();
+    level.seed = reader.read<uint32_t>();
+    if (stress) {
+        _session.stressLevel = level;
+    }
+    if (version >= 2) {
+        _session.level.resize(reader.read<uint32_t>());
+        for (auto& c : _session.level) {
+            c = reader.read<char>();
+        }
+    } else if (!stress) {
+        // Version 1 ran the built-in test level, which is now a level file
+        _session.level = (BINARY_ROOT / "levels" / "test.level").string();
+    }
+
+    uint64_t tick = 0;
+    while (!reader.done()) {
+        auto kind = reader.read<uint8_t>();
+        tick += reader.readVarint();
+        if (kind == ControlKind) {
+            auto x = reader.read<float>();
+            auto y = reader.read<float>();
+            _controls.push_back({.tick = tick, .control = {x, y}});
+        } else if (kind == ChecksumKind) {
+            _checksums.push_back({.tick = tick, .checksum = reader.read<uint64_t>()});
+        } else {
+            throw Error{} << "unknown entry " << int{kind} << " in " << path.string();
+        }
+        _ticks = std::max(_ticks, tick);
+    }
+}
+
+void InputReplay::feed(uint64_t tick, evening::Channel& controlEvents)
+{
+    for (; _nextControl < _controls.size() &&
+            _controls[_nextControl].tick <= tick; _nextControl++) {
+        controlEvents.push(_controls[_nextControl].control);
+    }
+}
+
+void InputReplay::verify(uint64_t tick, uint64_t checksum)
+{
+    while (_nextChecksum < _checksums.size() &&
+            _checksums[_nextChecksum].tick < tick) {
+        _nextChecksum++;
+    }
+    if (_nextChecksum == _checksums.size() ||
+            _checksums[_nextChecksum].tick != tick) {
+        return;
+    }
+
+    if (_checksums[_nextChecksum].checksum == checksum) {
+        _verifiedTicks++;
+    } else if (!_firstMismatch) {
+        _firstMismatch = tick;
+    }
+    _nextChecksum++;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "types.hpp"
+#include "world.hpp"
+
+#include "evening.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// What a recorded session starts from, so that a replay can build the same
+// world. Collisions resolve differently with one thread and with several, so
+// the thread count is part of it, and so is region streaming, which stops
+// simulating objects away from the focus.
+struct SessionInfo {
+    int tickRate = 60;
+    int threads = 1;
+    RegionStreaming streaming;
+    std::optional<StressLevel> stressLevel;
+    std::string level; // level file, used when there is no stress level
+};
+
+void initLevel(World& world, const SessionInfo& session);
+
+// Binary log of control input and world checksums, keyed by simulation tick.
+// Controls are logged with the tick they take effect before; checksums with
+// the tick that produced them. Entries store the tick as a varint delta from
+// the previous entry.
+class InputRecorder {
+public:
+    InputRecorder(const std::filesystem::path& path, const SessionInfo& session);
+
+    void control(uint64_t tick, const XYVector& control);
+    void checksum(uint64_t tick, uint64_t checksum);
+
+private:
+    void entry(uint8_t kind, uint64_t tick);
+
+    std::ofstream _output;
+    uint64_t _lastTick = 0;
+};
+
+// Feeds a recorded session back into a World, one tick at a time, and checks
+// that the world goes through the same states
+class InputReplay {
+public:
+    explicit InputReplay(const std::filesystem::path& path);
+
+    const SessionInfo& session() const { return _session; }
+    uint64_t ticks() const { return _ticks; }
+
+    // Pushes the controls recorded before this tick
+    void feed(uint64_t tick, evening::Channel& controlEvents);
+
+    // Compares against the checksum recorded after this tick, if any
+    void verify(uint64_t tick, uint64_t checksum);
+
+    size_t verifiedTicks() const { return _verifiedTicks; }
+    std::optional<uint64_t> firstMismatch() const { return _firstMismatch; }
+
+private:
+    struct ControlEntry {
+        uint64_t tick = 0;
+        XYVector control;
+    };
+
+    struct ChecksumEntry {
+        uint64_t tick = 0;
+        uint64_t checksum = 0;
+    };
+
+    SessionInfo _session;
+    uint64_t _ticks = 0;
+    std::vector<ControlEntry> _controls;
+    std::vector<ChecksumEntry> _checksums;
+    size_t _nextControl = 0;
+    size_t _nextChecksum = 0;
+    size_t _verifiedTicks = 0;
+    std::optional<uint64_t> _firstMismatch;
+};
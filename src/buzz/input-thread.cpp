@@ -0,0 +1,54 @@
+#include "input-thread.hpp"
+
+#include "profiler.hpp"
+
+namespace {
+
+// How long a wait for events may take, which bounds how late a stop request
+// is noticed
+constexpr int WaitMilliseconds = 5;
+
+} // namespace
+
+InputThread::InputThread()
+    : _thread([this] (std::stop_token stopToken) { run(stopToken); })
+{ }
+
+void InputThread::run(std::stop_token stopToken)
+{
+    setProfileThreadName("input");
+
+    while (!stopToken.stop_requested()) {
+        auto e = SDL_Event{};
+        if (!SDL_WaitEventTimeout(&e, WaitMilliseconds)) {
+            continue;
+        }
+
+        do {
+            const auto time = FixedStep::Clock::now();
+            if (_controller.handle(e)) {
+                push(_controls, TimedControl{
+                    .time = time,
+                    .control = _controller.control(),
+                    .timestamp = e.key.timestamp,
+                }, stopToken);
+            } else {
+                push(_events, e, stopToken);
+            }
+        } while (SDL_PollEvent(&e));
+    }
+}
+
+template <class Ring, class T>
+void InputThread::push(Ring& ring, const T& value, std::stop_token stopToken)
+{
+    if (ring.push(value)) {
+        return;
+    }
+
+    // Nothing is dropped: a lost key release would leave a control stuck
+    _stalls.fetch_add(1, std::memory_order_relaxed);
+    while (!ring.push(value) && !stopToken.stop_requested()) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "fixed-step.hpp"
+#include "keyboard-controller.hpp"
+#include "sdl.hpp"
+#include "spsc-ring.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <stop_token>
+#include <thread>
+
+// A control state, and the time it was read. The timestamp is the SDL one
+// of the key event, for latency measurement.
+struct TimedControl {
+    FixedStep::Clock::time_point time;
+    XYVector control;
+    uint32_t timestamp = 0;
+};
+
+using ControlRing = SpscRing<TimedControl, 256>;
+using InputEventRing = SpscRing<SDL_Event, 256>;
+
+// Pumps SDL events on a thread of its own, so that input is read while the
+// render thread waits for vsync. Control key changes become timestamped
+// control states for the simulation; all other events are passed on to the
+// View. SDL only supports pumping events off the main thread on some video
+// backends (X11, Wayland, KMSDRM and dummy among them), which is why this is
+// opt-in. SDL video must be initialized before construction.
+class InputThread {
+public:
+    InputThread();
+
+    InputThread(const InputThread&) = delete;
+    InputThread& operator=(const InputThread&) = delete;
+
+    ControlRing& controls() { return _controls; }
+    InputEventRing& events() { return _events; }
+
+    // Items that waited for the consumer because a ring was full
+    uint64_t stalls() const { return _stalls.load(std::memory_order_relaxed); }
+
+private:
+    void run(std::stop_token stopToken);
+
+    template <class Ring, class T>
+    void push(Ring& ring, const T& value, std::stop_token stopToken);
+
+    ControlRing _controls;
+    InputEventRing _events;
+    KeyboardControllerState _controller;
+    std::atomic<uint64_t> _stalls {0};
+    std::jthread _thread;
+};
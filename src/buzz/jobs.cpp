@@ -0,0 +1,126 @@
+#include "jobs.hpp"
+
+#include "error.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+
+JobPool::JobPool(int threads)
+{
+    check(threads >= 1);
+
+    for (int i = 0; i < threads; i++) {
+        _queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < threads; i++) {
+        _workers.emplace_back([this, i] (std::stop_token stopToken) {
+            work(stopToken, i);
+        });
+    }
+}
+
+JobPool::~JobPool()
+{
+    for (auto& worker : _workers) {
+        worker.request_stop();
+    }
+    _wake.notify_all();
+    _workers.clear();
+}
+
+int JobPool::threadCount() const
+{
+    return static_cast<int>(_queues.size());
+}
+
+void JobPool::parallelFor(
+    size_t count, size_t grainSize, const RangeFunction& body)
+{
+    if (count == 0) {
+        return;
+    }
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    const size_t chunks = (count + grainSize - 1) / grainSize;
+    if (_workers.empty() || chunks == 1) {
+        body(0, count);
+        return;
+    }
+
+    auto remaining = std::atomic<size_t>{chunks};
+    for (size_t i = 0; i < chunks; i++) {
+        auto& queue = *_queues[i % _queues.size()];
+        auto lock = std::scoped_lock{queue.mutex};
+        queue.tasks.push_back(Task{
+            .body = &body,
+            .begin = i * grainSize,
+            .end = std::min(count, (i + 1) * grainSize),
+            .remaining = &remaining,
+        });
+    }
+    {
+        auto lock = std::scoped_lock{_wakeMutex};
+        _pending += chunks;
+    }
+    _wake.notify_all();
+
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!runOne(0)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobPool::runOne(size_t self)
+{
+    auto task = Task{};
+    bool found = false;
+
+    {
+        auto& own = *_queues[self];
+        auto lock = std::scoped_lock{own.mutex};
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    for (size_t i = 1; !found && i < _queues.size(); i++) {
+        auto& victim = *_queues[(self + i) % _queues.size()];
+        auto lock = std::scoped_lock{victim.mutex};
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    _pending.fetch_sub(1, std::memory_order_relaxed);
+    {
+        auto zone = ProfileZone{"job"};
+        (*task.body)(task.begin, task.end);
+    }
+    task.remaining->fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobPool::work(std::stop_token stopToken, size_t self)
+{
+    setProfileThreadName("jobs " + std::to_string(self));
+
+    while (!stopToken.stop_requested()) {
+        if (runOne(self)) {
+            continue;
+        }
+
+        auto lock = std::unique_lock{_wakeMutex};
+        _wake.wait(lock, stopToken, [this] {
+            return _pending.load(std::memory_order_relaxed) > 0;
+        });
+    }
+}
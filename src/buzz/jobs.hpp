@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with per-thread task queues. A thread takes
+// work from the back of its own queue, and steals from the front of other
+// queues when it runs out. The thread calling parallelFor works too.
+class JobPool {
+public:
+    using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+    // threads counts the calling thread, so JobPool{1} starts no workers
+    explicit JobPool(int threads);
+    ~JobPool();
+
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    int threadCount() const;
+
+    // Splits [0, count) into chunks of at most grainSize elements and runs
+    // body on every chunk. Returns when all chunks are done.
+    void parallelFor(size_t count, size_t grainSize, const RangeFunction& body);
+
+private:
+    struct Task {
+        const RangeFunction* body = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        std::atomic<size_t>* remaining = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool runOne(size_t self);
+    void work(std::stop_token stopToken, size_t self);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::jthread> _workers;
+
+    std::mutex _wakeMutex;
+    std::condition_variable_any _wake;
+    std::atomic<size_t> _pending {0};
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "sdl.hpp"
+#include "types.hpp"
+
+struct KeyboardControllerState {
+    bool leftPressed = false;
+    bool rightPressed = false;
+    bool upPressed = false;
+    bool downPressed = false;
+
+    XYVector control() const
+    {
+        return XYVector{
+            1.f * rightPressed - leftPressed,
+            1.f * upPressed - downPressed};
+    }
+
+    // Returns true if the event was a press or release of a control key
+    bool handle(const SDL_Event& e)
+    {
+        if ((e.type != SDL_KEYDOWN && e.type != SDL_KEYUP) || e.key.repeat != 0) {
+            return false;
+        }
+
+        const bool pressed = e.type == SDL_KEYDOWN;
+        switch (e.key.keysym.sym) {
+            case SDLK_a: leftPressed = pressed; return true;
+            case SDLK_d: rightPressed = pressed; return true;
+            case SDLK_w: upPressed = pressed; return true;
+            case SDLK_s: downPressed = pressed; return true;
+            default: return false;
+        }
+    }
+};
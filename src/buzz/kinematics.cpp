@@ -0,0 +1,214 @@
+#include "kinematics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define BUZZ_X86 1
+    #include <immintrin.h>
+#endif
+
+void Kinematics::resize(size_t size)
+{
+    positionX.resize(size);
+    positionY.resize(size);
+    velocityX.resize(size);
+    velocityY.resize(size);
+    maxSpeed.resize(size);
+    deceleration.resize(size);
+    moved.resize(size);
+}
+
+void Kinematics::reserve(size_t size)
+{
+    positionX.reserve(size);
+    positionY.reserve(size);
+    velocityX.reserve(size);
+    velocityY.reserve(size);
+    maxSpeed.reserve(size);
+    deceleration.reserve(size);
+    moved.reserve(size);
+}
+
+void Kinematics::swapRemove(size_t slot)
+{
+    auto remove = [slot] (auto& values) {
+        values[slot] = values.back();
+        values.pop_back();
+    };
+    remove(positionX);
+    remove(positionY);
+    remove(velocityX);
+    remove(velocityY);
+    remove(maxSpeed);
+    remove(deceleration);
+    remove(moved);
+}
+
+namespace {
+
+void integrateScalar(Kinematics& k, size_t begin, size_t end, float delta)
+{
+    for (size_t i = begin; i < end; i++) {
+        float speed =
+            std::sqrt(k.velocityX[i] * k.velocityX[i] + k.velocityY[i] * k.velocityY[i]);
+        if (speed > 0) {
+            float targetSpeed = std::min(
+                std::max(speed - k.deceleration[i] * delta, 0.f),
+                k.maxSpeed[i]);
+            float scale = targetSpeed / speed;
+            k.velocityX[i] *= scale;
+            k.velocityY[i] *= scale;
+        }
+        k.moved[i] = speed > 0;
+        k.positionX[i] += k.velocityX[i] * delta;
+        k.positionY[i] += k.velocityY[i] * delta;
+    }
+}
+
+#ifdef BUZZ_X86
+
+void integrateSse(Kinematics& k, size_t begin, size_t end, float delta)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 d = _mm_set1_ps(delta);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_loadu_ps(&k.velocityX[i]);
+        __m128 vy = _mm_loadu_ps(&k.velocityY[i]);
+        __m128 speed = _mm_sqrt_ps(
+            _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+        __m128 targetSpeed = _mm_min_ps(
+            _mm_max_ps(
+                _mm_sub_ps(
+                    speed, _mm_mul_ps(_mm_loadu_ps(&k.deceleration[i]), d)),
+                zero),
+            _mm_loadu_ps(&k.maxSpeed[i]));
+        __m128 moving = _mm_cmpgt_ps(speed, zero);
+        __m128 scale = _mm_or_ps(
+            _mm_and_ps(moving, _mm_div_ps(targetSpeed, speed)),
+            _mm_andnot_ps(moving, one));
+        vx = _mm_mul_ps(vx, scale);
+        vy = _mm_mul_ps(vy, scale);
+        _mm_storeu_ps(&k.velocityX[i], vx);
+        _mm_storeu_ps(&k.velocityY[i], vy);
+        _mm_storeu_ps(&k.positionX[i], _mm_add_ps(
+            _mm_loadu_ps(&k.positionX[i]), _mm_mul_ps(vx, d)));
+        _mm_storeu_ps(&k.positionY[i], _mm_add_ps(
+            _mm_loadu_ps(&k.positionY[i]), _mm_mul_ps(vy, d)));
+
+        int mask = _mm_movemask_ps(moving);
+        for (int j = 0; j < 4; j++) {
+            k.moved[i + j] = (mask >> j) & 1;
+        }
+    }
+    integrateScalar(k, i, end, delta);
+}
+
+__attribute__((target("avx2")))
+void integrateAvx2(Kinematics& k, size_t begin, size_t end, float delta)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 d = _mm256_set1_ps(delta);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 vx = _mm256_loadu_ps(&k.velocityX[i]);
+        __m256 vy = _mm256_loadu_ps(&k.velocityY[i]);
+        __m256 speed = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+        __m256 targetSpeed = _mm256_min_ps(
+            _mm256_max_ps(
+                _mm256_sub_ps(
+                    speed,
+                    _mm256_mul_ps(_mm256_loadu_ps(&k.deceleration[i]), d)),
+                zero),
+            _mm256_loadu_ps(&k.maxSpeed[i]));
+        __m256 moving = _mm256_cmp_ps(speed, zero, _CMP_GT_OQ);
+        __m256 scale = _mm256_blendv_ps(
+            one, _mm256_div_ps(targetSpeed, speed), moving);
+        vx = _mm256_mul_ps(vx, scale);
+        vy = _mm256_mul_ps(vy, scale);
+        _mm256_storeu_ps(&k.velocityX[i], vx);
+        _mm256_storeu_ps(&k.velocityY[i], vy);
+        _mm256_storeu_ps(&k.positionX[i], _mm256_add_ps(
+            _mm256_loadu_ps(&k.positionX[i]), _mm256_mul_ps(vx, d)));
+        _mm256_storeu_ps(&k.positionY[i], _mm256_add_ps(
+            _mm256_loadu_ps(&k.positionY[i]), _mm256_mul_ps(vy, d)));
+
+        int mask = _mm256_movemask_ps(moving);
+        for (int j = 0; j < 8; j++) {
+            k.moved[i + j] = (mask >> j) & 1;
+        }
+    }
+    integrateScalar(k, i, end, delta);
+}
+
+#endif
+
+KernelIsa detectKernelIsa()
+{
+    auto best = KernelIsa::Scalar;
+#ifdef BUZZ_X86
+    best = KernelIsa::Sse;
+    if (__builtin_cpu_supports("avx2")) {
+        best = KernelIsa::Avx2;
+    }
+#endif
+
+    if (const char* forced = std::getenv("BUZZ_KERNEL_ISA")) {
+        auto name = std::string_view{forced};
+        if (name == "scalar") {
+            best = KernelIsa::Scalar;
+        } else if (name == "sse" && best == KernelIsa::Avx2) {
+            best = KernelIsa::Sse;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+KernelIsa kernelIsa()
+{
+    static const KernelIsa isa = detectKernelIsa();
+    return isa;
+}
+
+const char* kernelIsaName(KernelIsa isa)
+{
+    switch (isa) {
+        case KernelIsa::Scalar: return "scalar";
+        case KernelIsa::Sse: return "sse";
+        case KernelIsa::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void integrate(Kinematics& kinematics, size_t begin, size_t end, float delta)
+{
+    integrate(kernelIsa(), kinematics, begin, end, delta);
+}
+
+void integrate(
+    KernelIsa isa, Kinematics& kinematics, size_t begin, size_t end, float delta)
+{
+    switch (isa) {
+#ifdef BUZZ_X86
+        case KernelIsa::Avx2:
+            integrateAvx2(kinematics, begin, end, delta);
+            return;
+        case KernelIsa::Sse:
+            integrateSse(kinematics, begin, end, delta);
+            return;
+#endif
+        default:
+            integrateScalar(kinematics, begin, end, delta);
+            return;
+    }
+}
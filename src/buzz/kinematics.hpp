@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays state of moving entities, for the integration kernel.
+// The world keeps its movers here for as long as they exist, one slot each.
+struct Kinematics {
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> maxSpeed;
+    std::vector<float> deceleration;
+    // Set by integrate() for entities that had a non-zero speed
+    std::vector<uint8_t> moved;
+
+    size_t size() const { return positionX.size(); }
+    void resize(size_t size);
+    void reserve(size_t size);
+    // Moves the last slot into this one
+    void swapRemove(size_t slot);
+};
+
+enum class KernelIsa {
+    Scalar,
+    Sse,
+    Avx2,
+};
+
+// Instruction set picked for integrate() on this CPU. Can be forced to a
+// lower level with BUZZ_KERNEL_ISA=scalar or BUZZ_KERNEL_ISA=sse.
+KernelIsa kernelIsa();
+const char* kernelIsaName(KernelIsa isa);
+
+// Applies deceleration to velocities in [begin, end), clamps speeds to the
+// maximum, and advances positions by delta seconds.
+//
+// All kernels do the same IEEE single precision operations in the same order
+// (sqrt and division are correctly rounded in SSE and AVX), so results are
+// bit-identical between them. Compared to the earlier per-entity code, which
+// computed the decelerated speed in double precision, speeds may differ by
+// one float ulp (relative error under 1.2e-7 per tick).
+void integrate(Kinematics& kinematics, size_t begin, size_t end, float delta);
+void integrate(
+    KernelIsa isa, Kinematics& kinematics, size_t begin, size_t end, float delta);
@@ -0,0 +1,32 @@
+#include "latency-stats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+void LatencyStats::report(std::ostream& output) const
+{
+    output << "input-to-present latency, ms: ";
+    if (_samples.empty()) {
+        output << "no samples\n";
+        return;
+    }
+
+    auto sorted = _samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted] (size_t p) {
+        return sorted[(sorted.size() - 1) * p / 100];
+    };
+    const double mean =
+        std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+
+    const auto flags = output.flags();
+    const auto precision = output.precision();
+    output << std::fixed << std::setprecision(1) <<
+        sorted.size() << " samples, mean " << mean <<
+        ", median " << percentile(50) <<
+        ", p95 " << percentile(95) <<
+        ", max " << sorted.back() << "\n";
+    output.flags(flags);
+    output.precision(precision);
+}
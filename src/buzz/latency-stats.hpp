@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Input-to-present latencies in milliseconds, as measured against SDL event
+// timestamps
+class LatencyStats {
+public:
+    void add(uint32_t milliseconds) { _samples.push_back(milliseconds); }
+    size_t count() const { return _samples.size(); }
+
+    // Sample count, mean, median, 95th percentile and maximum
+    void report(std::ostream& output) const;
+
+private:
+    std::vector<uint32_t> _samples;
+};
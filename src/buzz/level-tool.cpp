@@ -0,0 +1,169 @@
+#include "error.hpp"
+#include "level.hpp"
+#include "world.hpp"
+
+#include "evening.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+void printUsage(std::ostream& output)
+{
+    output <<
+        "usage:\n"
+        "  buzz-level convert INPUT.txt OUTPUT.level\n"
+        "  buzz-level generate OUTPUT.level [options]\n"
+        "      --obstacles N  static obstacles (default 1000)\n"
+        "      --movers N     moving objects (default 10)\n"
+        "      --controlled   movers follow control input instead of wandering\n"
+        "      --density F    obstacles per square unit (default 0.05)\n"
+        "      --seed N       random seed (default 1)\n"
+        "  buzz-level dump INPUT.level\n"
+        "\n"
+        "Text levels have one object per line:\n"
+        "  TYPE X Y RADIUS [move MAX_SPEED ACCELERATION_TIME DECELERATION_TIME\n"
+        "      [controlled] [wander]]\n";
+}
+
+LevelData parseTextLevel(const std::string& path)
+{
+    auto input = std::ifstream{path};
+    if (!input) {
+        throw Error{} << "cannot open " << path;
+    }
+
+    auto level = LevelData{};
+    int lineNumber = 0;
+    for (std::string line; std::getline(input, line); ) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        auto stream = std::istringstream{line};
+        std::string typeName;
+        if (!(stream >> typeName)) {
+            continue;
+        }
+
+        auto object = LevelObject{.type = level.typeIndex(objectType(typeName))};
+        if (!(stream >> object.x >> object.y >> object.radius)) {
+            throw Error{} << path << ":" << lineNumber << ": bad object";
+        }
+        const auto objectIndex = static_cast<uint32_t>(level.objects.size());
+        level.objects.push_back(object);
+
+        std::string word;
+        if (!(stream >> word)) {
+            continue;
+        }
+        auto movement = LevelMovement{.object = objectIndex};
+        if (word != "move" || !(stream >>
+                movement.maxSpeed >>
+                movement.accelerationTime >>
+                movement.decelerationTime)) {
+            throw Error{} << path << ":" << lineNumber << ": bad movement";
+        }
+        while (stream >> word) {
+            if (word == "controlled") {
+                movement.flags |= LevelMovementFlags::Controlled;
+            } else if (word == "wander") {
+                movement.flags |= LevelMovementFlags::Wandering;
+            } else {
+                throw Error{} << path << ":" << lineNumber << ": unknown flag " << word;
+            }
+        }
+        level.movements.push_back(movement);
+    }
+    return level;
+}
+
+void dumpLevel(const std::string& path)
+{
+    auto level = LevelFile{path};
+    auto movements = std::vector<const LevelMovement*>(level.objects().size());
+    for (const auto& movement : level.movements()) {
+        movements[movement.object] = &movement;
+    }
+
+    std::cout << "# " << level.objects().size() << " objects, " <<
+        level.movements().size() << " moving\n";
+    for (size_t i = 0; i < level.objects().size(); i++) {
+        const auto& object = level.objects()[i];
+        const auto& type = level.types()[object.type];
+        std::cout << typeName(type) << " " << object.x << " " << object.y << " " << object.radius;
+        if (const auto* movement = movements[i]) {
+            std::cout << " move " << movement->maxSpeed << " " <<
+                movement->accelerationTime << " " << movement->decelerationTime;
+            if (movement->flags & LevelMovementFlags::Controlled) {
+                std::cout << " controlled";
+            }
+            if (movement->flags & LevelMovementFlags::Wandering) {
+                std::cout << " wander";
+            }
+        }
+        std::cout << "\n";
+    }
+}
+
+void generateLevel(int argc, char* argv[])
+{
+    auto level = StressLevel{};
+    for (int i = 3; i < argc; i++) {
+        auto arg = std::string_view{argv[i]};
+        auto value = [&] {
+            if (i + 1 >= argc) {
+                throw Error{} << "missing value for " << arg;
+            }
+            return std::string{argv[++i]};
+        };
+
+        if (arg == "--obstacles") {
+            level.obstacles = std::stoi(value());
+        } else if (arg == "--movers") {
+            level.movers = std::stoi(value());
+        } else if (arg == "--controlled") {
+            level.randomMovers = false;
+        } else if (arg == "--density") {
+            level.obstacleDensity = std::stof(value());
+        } else if (arg == "--seed") {
+            level.seed = std::stoul(value());
+        } else {
+            throw Error{} << "unknown option: " << arg;
+        }
+    }
+    check(level.obstacles >= 0 && level.movers >= 0 && level.obstacleDensity > 0);
+
+    evening::Channel worldEvents;
+    evening::Channel controlEvents;
+    auto world = World{worldEvents, controlEvents};
+    world.initStressLevel(level);
+    writeLevel(argv[2], world.exportLevel());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) try
+{
+    auto command = std::string_view{argc > 1 ? argv[1] : ""};
+    if (command == "convert" && argc == 4) {
+        writeLevel(argv[3], parseTextLevel(argv[2]));
+    } else if (command == "generate" && argc >= 3) {
+        generateLevel(argc, argv);
+    } else if (command == "dump" && argc == 3) {
+        dumpLevel(argv[2]);
+    } else if (command == "--help" || command == "-h") {
+        printUsage(std::cout);
+    } else {
+        printUsage(std::cerr);
+        return 1;
+    }
+} catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+}
@@ -0,0 +1,160 @@
+#include "level.hpp"
+
+#include "error.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+static_assert(std::endian::native == std::endian::little);
+
+template <class T>
+std::span<const T> section(
+    std::string_view name,
+    const void* data,
+    size_t size,
+    uint32_t offset,
+    uint32_t count)
+{
+    if (offset % alignof(T) != 0 ||
+            offset > size ||
+            count > (size - offset) / sizeof(T)) {
+        throw Error{} << name << " is truncated or corrupt";
+    }
+    return {
+        reinterpret_cast<const T*>(static_cast<const char*>(data) + offset),
+        count};
+}
+
+template <class T>
+void copySection(
+    std::vector<char>& image, uint32_t offset, const std::vector<T>& records)
+{
+    std::memcpy(image.data() + offset, records.data(), records.size() * sizeof(T));
+}
+
+} // namespace
+
+const char* objectTypeName(ObjectType type)
+{
+    switch (type) {
+        case ObjectType::Hero: return "hero";
+        case ObjectType::Tree: return "tree";
+    }
+    throw Error{} << "unknown object type " << static_cast<int>(type);
+}
+
+ObjectType objectType(std::string_view name)
+{
+    for (auto type : {ObjectType::Hero, ObjectType::Tree}) {
+        if (name == objectTypeName(type)) {
+            return type;
+        }
+    }
+    throw Error{} << "unknown object type " << name;
+}
+
+std::string_view typeName(const LevelObjectType& type)
+{
+    auto end = std::find(std::begin(type.name), std::end(type.name), '\0');
+    return {std::begin(type.name), end};
+}
+
+LevelView::LevelView(const void* data, size_t size, std::string_view name)
+{
+    auto header = LevelHeader{};
+    if (size < sizeof(header)) {
+        throw Error{} << name << " is not a buzz level";
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, LevelHeader{}.magic, sizeof(header.magic)) != 0) {
+        throw Error{} << name << " is not a buzz level";
+    }
+    if (header.version != LevelVersion) {
+        throw Error{} << name << " has level format version " <<
+            header.version << ", expected " << LevelVersion;
+    }
+
+    _types = section<LevelObjectType>(
+        name, data, size, header.typesOffset, header.typeCount);
+    _objects = section<LevelObject>(
+        name, data, size, header.objectsOffset, header.objectCount);
+    _movements = section<LevelMovement>(
+        name, data, size, header.movementsOffset, header.movementCount);
+
+    for (const auto& object : _objects) {
+        check(object.type < _types.size());
+    }
+    auto moving = std::vector<bool>(_objects.size());
+    for (const auto& movement : _movements) {
+        check(movement.object < _objects.size());
+        if (moving[movement.object]) {
+            throw Error{} << name << " has more than one movement " <<
+                "for object " << movement.object;
+        }
+        moving[movement.object] = true;
+    }
+}
+
+LevelFile::LevelFile(const fs::path& path)
+    : _file(path)
+{
+    static_cast<LevelView&>(*this) =
+        LevelView{_file.data(), _file.size(), path.string()};
+}
+
+uint32_t LevelData::typeIndex(ObjectType type)
+{
+    const char* name = objectTypeName(type);
+    for (uint32_t i = 0; i < types.size(); i++) {
+        if (std::strncmp(types[i].name, name, sizeof(types[i].name)) == 0) {
+            return i;
+        }
+    }
+
+    auto& added = types.emplace_back();
+    std::strncpy(added.name, name, sizeof(added.name) - 1);
+    return static_cast<uint32_t>(types.size() - 1);
+}
+
+std::vector<char> encodeLevel(const LevelData& level)
+{
+    auto header = LevelHeader{
+        .typeCount = static_cast<uint32_t>(level.types.size()),
+        .objectCount = static_cast<uint32_t>(level.objects.size()),
+        .movementCount = static_cast<uint32_t>(level.movements.size()),
+    };
+    header.typesOffset = sizeof(LevelHeader);
+    header.objectsOffset =
+        header.typesOffset + header.typeCount * sizeof(LevelObjectType);
+    header.movementsOffset =
+        header.objectsOffset + header.objectCount * sizeof(LevelObject);
+
+    auto image = std::vector<char>(
+        header.movementsOffset + header.movementCount * sizeof(LevelMovement));
+    std::memcpy(image.data(), &header, sizeof(header));
+    copySection(image, header.typesOffset, level.types);
+    copySection(image, header.objectsOffset, level.objects);
+    copySection(image, header.movementsOffset, level.movements);
+    return image;
+}
+
+void writeLevel(const fs::path& path, const LevelData& level)
+{
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path());
+    }
+    auto output = std::ofstream{path, std::ios::binary};
+    if (!output) {
+        throw Error{} << "cannot create " << path.string();
+    }
+    const auto image = encodeLevel(level);
+    output.write(image.data(), static_cast<std::streamsize>(image.size()));
+    check(output.good());
+}
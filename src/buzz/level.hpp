@@ -0,0 +1,105 @@
+#pragma once
+
+#include "events.hpp"
+#include "mapped-file.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Binary level format. A header is followed by three sections of packed
+// little-endian records, each 4-byte aligned at the offset the header gives:
+// the object type table, one LevelObject per object, and one LevelMovement
+// per moving object. Objects refer to types by index into the table, and the
+// table names types, so files stay valid when ObjectType values change.
+
+constexpr uint32_t LevelVersion = 1;
+
+struct LevelHeader {
+    char magic[4] {'B', 'Z', 'L', 'V'};
+    uint32_t version = LevelVersion;
+    uint32_t typeCount = 0;
+    uint32_t typesOffset = 0;
+    uint32_t objectCount = 0;
+    uint32_t objectsOffset = 0;
+    uint32_t movementCount = 0;
+    uint32_t movementsOffset = 0;
+};
+
+struct LevelObjectType {
+    char name[16] {};
+};
+
+// A WorldLocation, and the kind of object at it
+struct LevelObject {
+    float x = 0.f;
+    float y = 0.f;
+    float radius = 0.f;
+    uint32_t type = 0;
+};
+
+enum LevelMovementFlags : uint32_t {
+    Controlled = 1,
+    Wandering = 2,
+};
+
+// A WorldMovement for one of the objects
+struct LevelMovement {
+    uint32_t object = 0;
+    uint32_t flags = 0;
+    float velocityX = 0.f;
+    float velocityY = 0.f;
+    float maxSpeed = 0.f;
+    float accelerationTime = 0.f;
+    float decelerationTime = 0.f;
+};
+
+static_assert(sizeof(LevelHeader) == 32);
+static_assert(sizeof(LevelObjectType) == 16);
+static_assert(sizeof(LevelObject) == 16);
+static_assert(sizeof(LevelMovement) == 28);
+
+const char* objectTypeName(ObjectType type);
+ObjectType objectType(std::string_view name);
+
+// The name in a type table entry, which is not null-terminated at full length
+std::string_view typeName(const LevelObjectType& type);
+
+// Checked record views into a level image in memory, which must outlive them
+class LevelView {
+public:
+    LevelView() = default;
+    LevelView(const void* data, size_t size, std::string_view name = "level");
+
+    std::span<const LevelObjectType> types() const { return _types; }
+    std::span<const LevelObject> objects() const { return _objects; }
+    std::span<const LevelMovement> movements() const { return _movements; }
+
+private:
+    std::span<const LevelObjectType> _types;
+    std::span<const LevelObject> _objects;
+    std::span<const LevelMovement> _movements;
+};
+
+// A level file mapped into memory; the record views point into the mapping
+class LevelFile : public LevelView {
+public:
+    explicit LevelFile(const std::filesystem::path& path);
+
+private:
+    MappedFile _file;
+};
+
+struct LevelData {
+    std::vector<LevelObjectType> types;
+    std::vector<LevelObject> objects;
+    std::vector<LevelMovement> movements;
+
+    uint32_t typeIndex(ObjectType type);
+};
+
+std::vector<char> encodeLevel(const LevelData& level);
+void writeLevel(const std::filesystem::path& path, const LevelData& level);
@@ -1,7 +1,15 @@
+#include "arena.hpp"
+#include "config.hpp"
 #include "error.hpp"
 #include "events.hpp"
+#include "frame-pacer.hpp"
+#include "input-log.hpp"
+#include "input-thread.hpp"
+#include "profiler.hpp"
 #include "scene.hpp"
 #include "sdl.hpp"
+#include "simulation.hpp"
+#include "startup.hpp"
 #include "world.hpp"
 
 #include "build-info.hpp"
@@ -10,37 +18,215 @@
 #include "ve.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <map>
+#include <memory>
 #include <tuple>
 #include <vector>
 
-int main()
+namespace {
+
+constexpr int MaxCatchUpTicks = 5;
+
+void reportReplay(const InputReplay& replay)
 {
-    evening::Channel worldEvents;
-    evening::Channel controlEvents;
+    std::cout << "replay finished, " << replay.verifiedTicks() <<
+        " ticks verified\n";
+    if (auto tick = replay.firstMismatch()) {
+        std::cerr << "replay diverged from the recording at tick " <<
+            *tick << "\n";
+    }
+}
 
-    auto world = World{worldEvents, controlEvents};
-    auto view = View{worldEvents, controlEvents};
+void runSerial(
+    View& view,
+    FramePacer& pacer,
+    evening::Channel& worldEvents,
+    evening::Channel& controlEvents,
+    const SessionInfo& session,
+    InputRecorder* recorder,
+    InputReplay* replay)
+{
+    using Clock = std::chrono::steady_clock;
 
-    world.initTestLevel();
+    auto world = World{worldEvents, controlEvents};
+    initLevel(world, session);
+    world.record(recorder);
+    startupPhase("world initialized");
 
-    auto timer = tempo::FrameTimer{60};
+    // A frame is drawn every time round, ticks or not; the pacer decides how
+    // often that is
+    auto timer = tempo::FrameTimer{session.tickRate};
+    auto previousFrameTime = Clock::now();
     for (;;) {
+        pacer.beginFrame();
+        frameArena().reset();
+        auto frameZone = ProfileZone{"frame"};
+
         if (!view.processEvents()) {
             break;
         }
 
-        controlEvents.deliver();
+        {
+            auto zone = ProfileZone{"controlEvents.deliver"};
+            controlEvents.deliver();
+        }
 
         if (int framesPassed = timer(); framesPassed > 0) {
+            // After a long stall, drop the lost time instead of simulating
+            // all of it at once and stalling even more
+            framesPassed = std::min(framesPassed, MaxCatchUpTicks);
+
             for (int i = 0; i < framesPassed; i++) {
+                if (replay) {
+                    replay->feed(world.tick(), controlEvents);
+                    controlEvents.deliver();
+                }
                 world.update(timer.delta());
+                if (replay) {
+                    replay->verify(world.tick(), world.checksum());
+                    if (world.tick() == replay->ticks()) {
+                        reportReplay(*replay);
+                    }
+                }
             }
 
+            world.publish();
+            {
+                auto zone = ProfileZone{"worldEvents.deliver"};
+                worldEvents.deliver();
+            }
+        }
+
+        auto now = Clock::now();
+        view.update(
+            std::chrono::duration<double>{now - previousFrameTime}.count());
+        previousFrameTime = now;
+        view.present();
+        pacer.endFrame(view.presentStartTime());
+    }
+}
+
+void runThreaded(
+    View& view,
+    FramePacer& pacer,
+    evening::Channel& worldEvents,
+    evening::Channel& controlEvents,
+    const SessionInfo& session,
+    InputRecorder* recorder,
+    InputThread* input)
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto simulation =
+        Simulation{controlEvents, session.tickRate, MaxCatchUpTicks};
+    initLevel(simulation.world(), session);
+    simulation.world().record(recorder);
+    if (input) {
+        view.readEvents(input->events());
+        simulation.readControls(input->controls());
+    }
+    startupPhase("world initialized");
+    simulation.start();
+
+    auto previousFrameTime = Clock::now();
+    for (;;) {
+        pacer.beginFrame();
+        frameArena().reset();
+        auto frameZone = ProfileZone{"frame"};
+
+        if (!view.processEvents()) {
+            break;
+        }
+
+        {
+            auto zone = ProfileZone{"controlEvents.deliver"};
+            controlEvents.deliver();
+        }
+
+        {
+            auto zone = ProfileZone{"worldEvents.deliver"};
+            simulation.deliver(worldEvents);
             worldEvents.deliver();
+        }
 
-            view.update(framesPassed * timer.delta());
-            view.present();
+        auto now = Clock::now();
+        view.update(
+            std::chrono::duration<double>{now - previousFrameTime}.count());
+        previousFrameTime = now;
+        view.present();
+        pacer.endFrame(view.presentStartTime());
+    }
+}
+
+} // namespace
+
+int main()
+{
+    setProfileThreadName("main");
+
+    evening::Channel worldEvents;
+    evening::Channel controlEvents;
+
+    auto session = SessionInfo{
+        .tickRate = config().tickRate,
+        .threads = config().simulationThreads,
+        .streaming = {
+            .regionSize = static_cast<float>(config().regionSize),
+            .activeRadius = config().activeRegions,
+        },
+        .level = config().level,
+    };
+
+    auto replay = std::unique_ptr<InputReplay>{};
+    if (!config().replayInput.empty()) {
+        replay = std::make_unique<InputReplay>(config().replayInput);
+        session = replay->session();
+    }
+    // BUZZ_TICK_RATE or a recording may hold anything
+    check(session.tickRate > 0);
+
+    auto recorder = std::unique_ptr<InputRecorder>{};
+    if (!config().recordInput.empty()) {
+        recorder = std::make_unique<InputRecorder>(config().recordInput, session);
+    }
+
+    // During a replay, keyboard control goes nowhere
+    evening::Channel ignoredControlEvents;
+    auto view = View{
+        worldEvents, replay ? ignoredControlEvents : controlEvents};
+    auto pacer = FramePacer{
+        parsePacingMode(config().pacing),
+        config().frameRate > 0 ? config().frameRate : view.refreshRate()};
+
+    // Replays are driven tick by tick from this thread. Input from an input
+    // thread goes straight to the simulation thread, so it needs one.
+    if ((config().threadedSimulation || config().inputThread) && !replay) {
+        auto input = std::unique_ptr<InputThread>{};
+        if (config().inputThread) {
+            input = std::make_unique<InputThread>();
         }
+        runThreaded(
+            view,
+            pacer,
+            worldEvents,
+            controlEvents,
+            session,
+            recorder.get(),
+            input.get());
+    } else {
+        runSerial(
+            view,
+            pacer,
+            worldEvents,
+            controlEvents,
+            session,
+            recorder.get(),
+            replay.get());
+    }
+
+    if (config().reportLatency) {
+        view.inputLatency().report(std::cout);
     }
 }
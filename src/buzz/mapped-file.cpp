@@ -0,0 +1,73 @@
+#include "mapped-file.hpp"
+
+#include "error.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+
+#if __has_include(<sys/mman.h>)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define BUZZ_HAS_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#ifdef BUZZ_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw Error{} << "cannot open " << path.string();
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        _size = static_cast<size_t>(info.st_size);
+        void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            _data = data;
+            _mapped = true;
+        }
+    }
+    ::close(fd);
+    if (_size == 0) {
+        throw Error{} << path.string() << " is empty";
+    }
+    if (!_mapped) {
+        throw Error{} << "cannot map " << path.string();
+    }
+#else
+    auto input = std::ifstream{path, std::ios::binary};
+    if (!input) {
+        throw Error{} << "cannot open " << path.string();
+    }
+    _buffer.assign(
+        std::istreambuf_iterator<char>{input},
+        std::istreambuf_iterator<char>{});
+    if (_buffer.empty()) {
+        throw Error{} << path.string() << " is empty";
+    }
+    _data = _buffer.data();
+    _size = _buffer.size();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef BUZZ_HAS_MMAP
+    if (_mapped) {
+        ::munmap(_data, _size);
+    }
+#endif
+}
+
+void MappedFile::prefault() const
+{
+    constexpr size_t PageSize = 4096;
+    volatile uint8_t sum = 0;
+    const auto* bytes = static_cast<const uint8_t*>(_data);
+    for (size_t i = 0; i < _size; i += PageSize) {
+        sum = sum + bytes[i];
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+// Read-only view of a whole file, memory-mapped where possible
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const void* data() const { return _data; }
+    size_t size() const { return _size; }
+
+    // Reads every page of the file, so that later accesses do not fault
+    void prefault() const;
+
+private:
+    void* _data = nullptr;
+    size_t _size = 0;
+    bool _mapped = false;
+    std::vector<char> _buffer;
+};
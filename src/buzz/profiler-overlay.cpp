@@ -0,0 +1,229 @@
+#include "profiler-overlay.hpp"
+
+#include "arena.hpp"
+#include "error.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+constexpr size_t FrameWindow = 120;
+constexpr size_t ShownZones = 6;
+constexpr int FontScale = 2;
+constexpr int GlyphWidth = 3;
+constexpr int GlyphHeight = 5;
+constexpr int Advance = (GlyphWidth + 1) * FontScale;
+constexpr int LineHeight = (GlyphHeight + 2) * FontScale;
+constexpr int Margin = 8;
+constexpr int GraphHeight = 50;
+constexpr double GraphMilliseconds = 33.3;
+
+const char* TickZoneName = "World::update";
+
+// 3x5 pixel glyphs, rows from the top
+const char* glyph(char c)
+{
+    switch (std::toupper(static_cast<unsigned char>(c))) {
+        case '0': return "####.##.##.####";
+        case '1': return ".#.##..#..#.###";
+        case '2': return "###..#####..###";
+        case '3': return "###..#.##..####";
+        case '4': return "#.##.####..#..#";
+        case '5': return "####..###..####";
+        case '6': return "####..####.####";
+        case '7': return "###..#..#.#..#.";
+        case '8': return "####.#####.####";
+        case '9': return "####.####..####";
+        case 'A': return ".#.#.#####.##.#";
+        case 'B': return "##.#.###.#.###.";
+        case 'C': return ".###..#..#...##";
+        case 'D': return "##.#.##.##.###.";
+        case 'E': return "####..##.#..###";
+        case 'F': return "####..##.#..#..";
+        case 'G': return ".###..#.##.#.##";
+        case 'H': return "#.##.#####.##.#";
+        case 'I': return "###.#..#..#.###";
+        case 'J': return "..#..#..##.#.#.";
+        case 'K': return "#.##.###.#.##.#";
+        case 'L': return "#..#..#..#..###";
+        case 'M': return "#.########.##.#";
+        case 'N': return "##.#.##.##.##.#";
+        case 'O': return ".#.#.##.##.#.#.";
+        case 'P': return "##.#.###.#..#..";
+        case 'Q': return ".#.#.##.###..##";
+        case 'R': return "##.#.###.#.##.#";
+        case 'S': return ".###...#...###.";
+        case 'T': return "###.#..#..#..#.";
+        case 'U': return "#.##.##.##.####";
+        case 'V': return "#.##.##.##.#.#.";
+        case 'W': return "#.##.########.#";
+        case 'X': return "#.##.#.#.#.##.#";
+        case 'Y': return "#.##.#.#..#..#.";
+        case 'Z': return "###..#.#.#..###";
+        case '.': return ".............#.";
+        case ':': return "....#.....#....";
+        case '-': return "......###......";
+        case '/': return "..#..#.#.#..#..";
+        case '_': return "............###";
+        case '(': return "..#.#..#..#...#";
+        case ')': return "#...#..#..#.#..";
+        case '%': return "#.#..#.#.#..#.#";
+        default: return "...............";
+    }
+}
+
+void drawText(
+    SDL_Renderer* renderer, int x, int y, std::string_view text)
+{
+    auto pixels = FrameVector<SDL_Rect>{};
+    for (size_t i = 0; i < text.size(); i++) {
+        const char* bits = glyph(text[i]);
+        for (int j = 0; j < GlyphWidth * GlyphHeight && bits[j]; j++) {
+            if (bits[j] == '#') {
+                pixels.push_back(SDL_Rect{
+                    .x = x + static_cast<int>(i) * Advance + j % GlyphWidth * FontScale,
+                    .y = y + j / GlyphWidth * FontScale,
+                    .w = FontScale,
+                    .h = FontScale,
+                });
+            }
+        }
+    }
+    sdlCheck(SDL_RenderFillRects(
+        renderer, pixels.data(), static_cast<int>(pixels.size())));
+}
+
+FrameString format(const char* pattern, double value)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), pattern, value);
+    return buffer;
+}
+
+double milliseconds(int64_t nanoseconds)
+{
+    return nanoseconds / 1e6;
+}
+
+} // namespace
+
+void ProfilerOverlay::frame()
+{
+    const auto now = profileClock();
+    if (_lastFrameTime == 0 || !profilingEnabled()) {
+        _lastFrameTime = now;
+        return;
+    }
+
+    _records.clear();
+    captureProfile(_records, _lastFrameTime);
+
+    auto sample = FrameSample{.duration = now - _lastFrameTime};
+    for (const auto& record : _records) {
+        if (std::strcmp(record.name, TickZoneName) == 0) {
+            sample.ticks++;
+        }
+        auto it = std::find_if(
+            sample.zones.begin(), sample.zones.end(), [&record] (const auto& z) {
+                return std::strcmp(z.first, record.name) == 0;
+            });
+        if (it == sample.zones.end()) {
+            sample.zones.emplace_back(record.name, record.end - record.start);
+        } else {
+            it->second += record.end - record.start;
+        }
+    }
+
+    _frames.push_back(std::move(sample));
+    if (_frames.size() > FrameWindow) {
+        _frames.pop_front();
+    }
+    _lastFrameTime = now;
+}
+
+void ProfilerOverlay::draw(SDL_Renderer* renderer) const
+{
+    if (_frames.empty()) {
+        return;
+    }
+
+    auto totalTime = int64_t{0};
+    auto maxTime = int64_t{0};
+    int ticks = 0;
+    auto slowest = FrameVector<std::pair<const char*, int64_t>>{};
+    for (const auto& frame : _frames) {
+        totalTime += frame.duration;
+        maxTime = std::max(maxTime, frame.duration);
+        ticks += frame.ticks;
+        for (const auto& [name, time] : frame.zones) {
+            auto it = std::find_if(
+                slowest.begin(), slowest.end(), [name] (const auto& z) {
+                    return std::strcmp(z.first, name) == 0;
+                });
+            if (it == slowest.end()) {
+                slowest.emplace_back(name, time);
+            } else {
+                it->second += time;
+            }
+        }
+    }
+
+    std::sort(slowest.begin(), slowest.end(), [] (const auto& a, const auto& b) {
+        return a.second > b.second;
+    });
+    slowest.resize(std::min(slowest.size(), ShownZones));
+
+    const auto frameCount = static_cast<double>(_frames.size());
+    const int width = static_cast<int>(FrameWindow) * 2;
+    const int height = LineHeight * static_cast<int>(3 + slowest.size()) +
+        GraphHeight + Margin;
+
+    sdlCheck(SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND));
+    sdlCheck(SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180));
+    auto panel = SDL_Rect{
+        .x = Margin, .y = Margin,
+        .w = width + 2 * Margin, .h = height + 2 * Margin};
+    sdlCheck(SDL_RenderFillRect(renderer, &panel));
+
+    int x = 2 * Margin;
+    int y = 2 * Margin;
+    sdlCheck(SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255));
+    drawText(renderer, x, y,
+        "frame " + format("%.2f", milliseconds(totalTime) / frameCount) +
+        " ms, max " + format("%.2f", milliseconds(maxTime)));
+    y += LineHeight;
+    drawText(renderer, x, y,
+        "ticks/frame " + format("%.2f", ticks / frameCount));
+    y += LineHeight;
+
+    auto bars = FrameVector<SDL_Rect>{};
+    for (size_t i = 0; i < _frames.size(); i++) {
+        int h = std::min(
+            GraphHeight,
+            static_cast<int>(
+                milliseconds(_frames[i].duration) / GraphMilliseconds * GraphHeight));
+        bars.push_back(SDL_Rect{
+            .x = x + static_cast<int>(i) * 2,
+            .y = y + GraphHeight - h,
+            .w = 2,
+            .h = h,
+        });
+    }
+    sdlCheck(SDL_SetRenderDrawColor(renderer, 120, 220, 120, 255));
+    sdlCheck(SDL_RenderFillRects(renderer, bars.data(), static_cast<int>(bars.size())));
+    y += GraphHeight + Margin;
+
+    sdlCheck(SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255));
+    for (const auto& [name, time] : slowest) {
+        drawText(renderer, x, y,
+            format("%6.2f", milliseconds(time) / frameCount) + "  " + name);
+        y += LineHeight;
+    }
+
+    sdlCheck(SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "profiler.hpp"
+#include "sdl.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+// On-screen summary of the last few seconds of profiling: a frame time graph,
+// simulation ticks per frame, and the zones taking the most time per frame
+class ProfilerOverlay {
+public:
+    // Call once per presented frame, to collect the zones recorded since the
+    // previous call
+    void frame();
+    void draw(SDL_Renderer* renderer) const;
+
+private:
+    struct FrameSample {
+        int64_t duration = 0;
+        int ticks = 0;
+        std::vector<std::pair<const char*, int64_t>> zones;
+    };
+
+    std::deque<FrameSample> _frames;
+    std::vector<ProfileRecord> _records;
+    int64_t _lastFrameTime = 0;
+};
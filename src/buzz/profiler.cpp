@@ -0,0 +1,161 @@
+#include "profiler.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+constexpr size_t RingSize = size_t{1} << 16;
+
+struct Slot {
+    std::atomic<const char*> name {nullptr};
+    std::atomic<int64_t> start {0};
+    std::atomic<int64_t> end {0};
+};
+
+struct ThreadRing {
+    int thread = 0;
+    std::string name;
+    std::atomic<uint64_t> head {0};
+    std::unique_ptr<Slot[]> slots = std::make_unique<Slot[]>(RingSize);
+};
+
+// Rings outlive their threads, so that a capture still shows finished work
+std::mutex ringsMutex;
+std::vector<std::shared_ptr<ThreadRing>> rings;
+
+ThreadRing& threadRing()
+{
+    thread_local auto ring = [] {
+        auto lock = std::scoped_lock{ringsMutex};
+        auto ring = std::make_shared<ThreadRing>();
+        ring->thread = static_cast<int>(rings.size());
+        ring->name = "thread " + std::to_string(ring->thread);
+        rings.push_back(ring);
+        return ring;
+    }();
+    return *ring;
+}
+
+void writeJsonString(std::ostream& output, const std::string& s)
+{
+    output << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            output << '\\';
+        }
+        output << c;
+    }
+    output << '"';
+}
+
+} // namespace
+
+std::atomic<bool> detail::profilingEnabled {false};
+
+void enableProfiling(bool enabled)
+{
+    detail::profilingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void setProfileThreadName(std::string name)
+{
+    auto& ring = threadRing();
+    auto lock = std::scoped_lock{ringsMutex};
+    ring.name = std::move(name);
+}
+
+int64_t profileClock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ProfileZone::record(const char* name, int64_t start, int64_t end)
+{
+    auto& ring = threadRing();
+    auto head = ring.head.load(std::memory_order_relaxed);
+    auto& slot = ring.slots[head % RingSize];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void captureProfile(std::vector<ProfileRecord>& records, int64_t since)
+{
+    auto lock = std::scoped_lock{ringsMutex};
+    for (const auto& ring : rings) {
+        const auto head = ring->head.load(std::memory_order_acquire);
+        const auto first = records.size();
+
+        // Records end in order, so walk back until the time limit
+        auto index = head;
+        while (index > 0 && head - index < RingSize) {
+            const auto& slot = ring->slots[(index - 1) % RingSize];
+            auto record = ProfileRecord{
+                .name = slot.name.load(std::memory_order_relaxed),
+                .start = slot.start.load(std::memory_order_relaxed),
+                .end = slot.end.load(std::memory_order_relaxed),
+                .thread = ring->thread,
+            };
+            if (record.end < since) {
+                break;
+            }
+            records.push_back(record);
+            index--;
+        }
+
+        // The owning thread may have lapped the slots read above; drop any
+        // that could have been overwritten while reading
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto newHead = ring->head.load(std::memory_order_relaxed);
+        const auto overwritten = newHead > RingSize ? newHead - RingSize : 0;
+        if (overwritten > index) {
+            const auto stale = std::min<uint64_t>(
+                overwritten - index, records.size() - first);
+            records.resize(records.size() - stale);
+        }
+    }
+}
+
+void writeChromeTrace(
+    std::ostream& output, const std::vector<ProfileRecord>& records)
+{
+    auto origin = int64_t{0};
+    for (const auto& record : records) {
+        if (origin == 0 || record.start < origin) {
+            origin = record.start;
+        }
+    }
+
+    const auto flags = output.flags();
+    const auto precision = output.precision();
+    output << std::fixed << std::setprecision(3);
+    output << "{\"traceEvents\":[\n";
+    bool first = true;
+    {
+        auto lock = std::scoped_lock{ringsMutex};
+        for (const auto& ring : rings) {
+            output << (first ? "" : ",\n") <<
+                R"({"name":"thread_name","ph":"M","pid":1,"tid":)" <<
+                ring->thread << R"(,"args":{"name":)";
+            writeJsonString(output, ring->name);
+            output << "}}";
+            first = false;
+        }
+    }
+    for (const auto& record : records) {
+        output << (first ? "" : ",\n") << R"({"name":)";
+        writeJsonString(output, record.name);
+        output << R"(,"ph":"X","pid":1,"tid":)" << record.thread <<
+            R"(,"ts":)" << (record.start - origin) / 1000.0 <<
+            R"(,"dur":)" << (record.end - record.start) / 1000.0 << "}";
+        first = false;
+    }
+    output << "\n]}\n";
+    output.flags(flags);
+    output.precision(precision);
+}
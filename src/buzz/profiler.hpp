@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Low-overhead instrumentation. Zones are recorded into per-thread ring
+// buffers, each written only by its own thread and read without locks; old
+// records are overwritten. When profiling is disabled, a zone costs one
+// relaxed atomic load.
+
+struct ProfileRecord {
+    const char* name = nullptr;
+    int64_t start = 0; // nanoseconds, steady clock
+    int64_t end = 0;
+    int thread = 0;
+};
+
+namespace detail {
+extern std::atomic<bool> profilingEnabled;
+} // namespace detail
+
+inline bool profilingEnabled()
+{
+    return detail::profilingEnabled.load(std::memory_order_relaxed);
+}
+
+void enableProfiling(bool enabled);
+void setProfileThreadName(std::string name);
+int64_t profileClock();
+
+// Measures the enclosing scope. The name must outlive the capture, which in
+// practice means a string literal.
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name)
+    {
+        if (profilingEnabled()) {
+            _name = name;
+            _start = profileClock();
+        }
+    }
+
+    ~ProfileZone()
+    {
+        if (_name) {
+            record(_name, _start, profileClock());
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+    static void record(const char* name, int64_t start, int64_t end);
+
+private:
+    const char* _name = nullptr;
+    int64_t _start = 0;
+};
+
+// Appends the records of all threads that ended after the given time, in no
+// particular order
+void captureProfile(std::vector<ProfileRecord>& records, int64_t since = 0);
+
+// Chrome trace-event JSON, for chrome://tracing or Perfetto
+void writeChromeTrace(std::ostream& output, const std::vector<ProfileRecord>& records);
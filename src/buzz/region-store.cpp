@@ -0,0 +1,26 @@
+#include "region-store.hpp"
+
+void RegionStore::store(const RegionCoord& region, LevelData level)
+{
+    if (!_encoder) {
+        _encoder = std::make_unique<AssetLoader>(1);
+    }
+    _regions[region].push_back(_encoder->submit([level = std::move(level)] {
+        return encodeLevel(level);
+    }));
+}
+
+std::vector<std::vector<char>> RegionStore::take(const RegionCoord& region)
+{
+    auto images = std::vector<std::vector<char>>{};
+    auto it = _regions.find(region);
+    if (it == _regions.end()) {
+        return images;
+    }
+
+    for (auto& pending : it->second) {
+        images.push_back(pending.get());
+    }
+    _regions.erase(it);
+    return images;
+}
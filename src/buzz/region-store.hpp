@@ -0,0 +1,34 @@
+#pragma once
+
+#include "asset-loader.hpp"
+#include "level.hpp"
+
+#include <compare>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+struct RegionCoord {
+    int x = 0;
+    int y = 0;
+
+    auto operator<=>(const RegionCoord&) const = default;
+};
+
+// Unloaded world regions, kept as level images in the file layout, with no
+// further compression. Encoding runs on a background thread, which is only
+// started with the first region stored; taking a region back waits for its
+// pending encodes. A region may be stored several times before it is taken,
+// e.g. as movers walk into it.
+class RegionStore {
+public:
+    void store(const RegionCoord& region, LevelData level);
+    std::vector<std::vector<char>> take(const RegionCoord& region);
+
+    size_t regionCount() const { return _regions.size(); }
+
+private:
+    std::map<RegionCoord, std::vector<std::future<std::vector<char>>>> _regions;
+    std::unique_ptr<AssetLoader> _encoder;
+};
@@ -0,0 +1,284 @@
+#include "capture.hpp"
+#include "error.hpp"
+#include "events.hpp"
+#include "input-log.hpp"
+#include "scene.hpp"
+#include "world.hpp"
+
+#include "evening.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Frames advance the view by a fixed step, so animations look the same on
+// every run
+constexpr double FrameDelta = 1.0 / 60;
+
+struct Options {
+    StressLevel level {.obstacles = 2'000, .movers = 200};
+    std::string levelPath;
+    int width = 640;
+    int height = 360;
+    bool native = false;
+    int frames = 300;
+    int warmupFrames = 10;
+    int captureEvery = 100;
+    float pathRadius = 20.f;
+    std::filesystem::path outputDirectory;
+    bool raw = false;
+    std::filesystem::path goldenDirectory;
+    int tolerance = 2;
+    double maxDifferentPercent = 0.0;
+    double maxP90Ms = 0.0; // 0 is no limit
+};
+
+void printUsage(std::ostream& output)
+{
+    output <<
+        "usage: buzz-render [options]\n"
+        "Renders frames offscreen along a scripted camera path, timing\n"
+        "View::present() and capturing some of the frames.\n"
+        "  --obstacles N    static obstacles in the level (default 2000)\n"
+        "  --movers N       moving objects in the level (default 200)\n"
+        "  --seed N         level generation seed (default 1)\n"
+        "  --level FILE     load a level file instead of generating one\n"
+        "  --width N        frame width in pixels (default 640)\n"
+        "  --height N       frame height in pixels (default 360)\n"
+        "  --native         render at native resolution and upscale\n"
+        "  --frames N       timed frames along the camera path (default 300)\n"
+        "  --warmup N       untimed frames before the path (default 10)\n"
+        "  --capture-every N\n"
+        "                   capture every Nth frame of the path (default 100)\n"
+        "  --radius N       camera path radius in world units (default 20)\n"
+        "  --output DIR     write captured frames to DIR\n"
+        "  --raw            write raw RGBA bytes instead of PNG\n"
+        "  --golden DIR     compare captured frames with the PNGs in DIR;\n"
+        "                   --output DIR with the same DIR updates them\n"
+        "  --tolerance N    channel difference still taken as equal\n"
+        "                   (default 2)\n"
+        "  --max-different P\n"
+        "                   percentage of pixels that may differ (default 0)\n"
+        "  --max-p90-ms MS  fail if the 90th percentile of present() times\n"
+        "                   is above MS milliseconds\n";
+}
+
+Options parseOptions(int argc, char* argv[])
+{
+    auto options = Options{};
+    for (int i = 1; i < argc; i++) {
+        auto arg = std::string_view{argv[i]};
+        auto string = [&] {
+            if (i + 1 >= argc) {
+                throw Error{} << "missing value for " << arg;
+            }
+            return std::string{argv[++i]};
+        };
+        auto value = [&] {
+            return std::stoi(string());
+        };
+
+        if (arg == "--obstacles") {
+            options.level.obstacles = value();
+        } else if (arg == "--movers") {
+            options.level.movers = value();
+        } else if (arg == "--seed") {
+            options.level.seed = value();
+        } else if (arg == "--level") {
+            options.levelPath = string();
+        } else if (arg == "--width") {
+            options.width = value();
+        } else if (arg == "--height") {
+            options.height = value();
+        } else if (arg == "--native") {
+            options.native = true;
+        } else if (arg == "--frames") {
+            options.frames = value();
+        } else if (arg == "--warmup") {
+            options.warmupFrames = value();
+        } else if (arg == "--capture-every") {
+            options.captureEvery = value();
+        } else if (arg == "--radius") {
+            options.pathRadius = static_cast<float>(value());
+        } else if (arg == "--output") {
+            options.outputDirectory = string();
+        } else if (arg == "--raw") {
+            options.raw = true;
+        } else if (arg == "--golden") {
+            options.goldenDirectory = string();
+        } else if (arg == "--tolerance") {
+            options.tolerance = value();
+        } else if (arg == "--max-different") {
+            options.maxDifferentPercent = std::stod(string());
+        } else if (arg == "--max-p90-ms") {
+            options.maxP90Ms = std::stod(string());
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(std::cout);
+            std::exit(0);
+        } else {
+            printUsage(std::cerr);
+            throw Error{} << "unknown option: " << arg;
+        }
+    }
+
+    check(options.width > 0 && options.height > 0 && options.frames > 0 &&
+        options.warmupFrames >= 0 && options.captureEvery > 0 &&
+        options.tolerance >= 0 && options.maxDifferentPercent >= 0 &&
+        options.maxP90Ms >= 0);
+    return options;
+}
+
+// A loop around the origin, stretched sideways like the screen
+XYVector cameraPath(int frame, int frames, float radius)
+{
+    const float angle = 2 * std::numbers::pi_v<float> * frame / frames;
+    return {radius * std::cos(angle), radius / 2 * std::sin(2 * angle)};
+}
+
+std::string frameName(int frame, std::string_view extension)
+{
+    char name[32];
+    std::snprintf(
+        name, sizeof(name), "frame-%04d.%s", frame, extension.data());
+    return name;
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    auto index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted.at(index);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) try
+{
+    const auto options = parseOptions(argc, argv);
+
+    useOffscreenRendering();
+    SDL_setenv(
+        "BUZZ_WINDOW_WIDTH", std::to_string(options.width).c_str(), 1);
+    SDL_setenv(
+        "BUZZ_WINDOW_HEIGHT", std::to_string(options.height).c_str(), 1);
+
+    evening::Channel worldEvents;
+    evening::Channel controlEvents;
+    auto view = View{worldEvents, controlEvents};
+    view.renderAtNativeResolution(options.native);
+
+    // The world is loaded but not simulated: frames differ only by the
+    // camera and the animations, which do not depend on floating-point
+    // details of the simulation
+    auto world = World{worldEvents, controlEvents};
+    auto session = SessionInfo{.level = options.levelPath};
+    if (options.levelPath.empty()) {
+        session.stressLevel = options.level;
+    }
+    initLevel(world, session);
+    worldEvents.deliver();
+
+    if (!options.outputDirectory.empty()) {
+        std::filesystem::create_directories(options.outputDirectory);
+    }
+
+    auto frame = [&] (int i) {
+        view.lookAt(cameraPath(i, options.frames, options.pathRadius));
+        view.update(FrameDelta);
+    };
+
+    for (int i = 0; i < options.warmupFrames; i++) {
+        frame(0);
+        view.present();
+    }
+
+    auto presentTimes = std::vector<double>(options.frames);
+    int captured = 0;
+    int failed = 0;
+    for (int i = 0; i < options.frames; i++) {
+        frame(i);
+        const auto presentStart = Clock::now();
+        view.present();
+        presentTimes[i] = std::chrono::duration<double, std::milli>(
+            Clock::now() - presentStart).count();
+
+        if (i % options.captureEvery != 0) {
+            continue;
+        }
+        auto image = view.capture();
+        captured++;
+
+        if (!options.outputDirectory.empty()) {
+            const auto path = options.outputDirectory /
+                frameName(i, options.raw ? "raw" : "png");
+            if (options.raw) {
+                writeRaw(image.get(), path);
+            } else {
+                writePng(image.get(), path);
+            }
+        }
+
+        if (!options.goldenDirectory.empty()) {
+            const auto path = options.goldenDirectory / frameName(i, "png");
+            if (!std::filesystem::exists(path)) {
+                std::cerr << "no golden image: " << path.string() << "\n";
+                failed++;
+                continue;
+            }
+            auto golden = readImage(path);
+            auto difference =
+                compareImages(image.get(), golden.get(), options.tolerance);
+            const double differentPercent = 100.0 *
+                difference.differentPixels / (image->w * image->h);
+            if (difference.sizeMismatch) {
+                std::cerr << path.string() << ": size differs, " <<
+                    golden->w << "x" << golden->h << " expected\n";
+                failed++;
+            } else if (differentPercent > options.maxDifferentPercent) {
+                std::cerr << path.string() << ": " <<
+                    difference.differentPixels << " pixels (" <<
+                    differentPercent << "%) differ, by up to " <<
+                    difference.maxChannelDifference << "\n";
+                failed++;
+            }
+        }
+    }
+
+    std::sort(presentTimes.begin(), presentTimes.end());
+    const double p90 = percentile(presentTimes, 0.9);
+    std::cout <<
+        "frame size: " << options.width << "x" << options.height <<
+            (options.native ? " (native resolution)" : "") << "\n" <<
+        "resident objects: " << world.residentObjects() << "\n" <<
+        "frames: " << options.frames << "\n" <<
+        "present, ms: " <<
+            "p50 " << percentile(presentTimes, 0.5) <<
+            ", p90 " << p90 <<
+            ", p99 " << percentile(presentTimes, 0.99) <<
+            ", max " << presentTimes.back() << "\n" <<
+        "captured frames: " << captured << "\n";
+    if (!options.goldenDirectory.empty()) {
+        std::cout << "golden mismatches: " << failed << "\n";
+    }
+    if (options.maxP90Ms > 0 && p90 > options.maxP90Ms) {
+        std::cerr << "present p90 " << p90 << " ms is over the limit of " <<
+            options.maxP90Ms << " ms\n";
+        failed++;
+    }
+    return failed > 0 ? 1 : 0;
+} catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+}
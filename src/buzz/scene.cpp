@@ -1,88 +1,42 @@
 #include "scene.hpp"
 
+#include "asset-loader.hpp"
 #include "config.hpp"
 #include "events.hpp"
+#include "frame-pacer.hpp"
+#include "profiler.hpp"
+#include "startup.hpp"
 #include "world.hpp"
 
 #include "build-info.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <fstream>
 #include <iostream>
 
 namespace {
 
 constexpr int PixelScale = 10;
 constexpr int PixelsInUnit = 8;
+constexpr float SpriteIndexCellSize = 4.f;
 
-} // namespace
-
-Texture::Texture(
-        SDL_Renderer* renderer, const std::filesystem::path& pathToImageFile)
+// Advances playback by delta seconds, returning the number of frames to step
+int advanceFrames(float& phase, float framesPerSecond, double delta)
 {
-    _sdlTexture.reset(
-        sdlCheck(IMG_LoadTexture(renderer, pathToImageFile.c_str())));
-    sdlCheck(SDL_QueryTexture(_sdlTexture.get(), nullptr, nullptr, &_width, &_height));
+    phase += static_cast<float>(delta) * framesPerSecond;
+    const int frames = static_cast<int>(phase);
+    phase -= frames;
+    return frames;
 }
 
-SDL_Texture* Texture::raw() const
-{
-    return _sdlTexture.get();
-}
-
-const int Texture::width() const
-{
-    return _width;
-}
-
-const int Texture::height() const
-{
-    return _height;
-}
-
-AnimatedSprite::AnimatedSprite(SDL_Texture* texture, int w, int h, int frames)
-    : _texture(texture)
-    , _width(w)
-    , _height(h)
-{
-    for (int i = 0; i < frames; i++) {
-        _frames.push_back({.x = i * w, .y = 0, .w = w, .h = h});
-    }
-}
+} // namespace
 
 void AnimatedSprite::update(double delta)
 {
-    _currentFrameIndex =
-        (_currentFrameIndex + _metronome.ticks(delta)) % _frames.size();
-}
-
-DirectionalSprite::DirectionalSprite(
-        SDL_Texture* texture, int w, int h, int frames)
-    : _texture(texture)
-    , _width(w)
-    , _height(h)
-    , _frameCount(frames)
-{
-    for (auto animatedMotion : {AnimatedMotion::Walk, AnimatedMotion::Stand}) {
-        for (auto animatedDirection : {
-                AnimatedDirection::Right,
-                AnimatedDirection::Left,
-                AnimatedDirection::Down,
-                AnimatedDirection::Up}) {
-            int i = _frames.size();
-            std::vector<SDL_Rect> rs;
-            for (int j = 0; j < _frameCount; j++) {
-                rs.push_back(SDL_Rect{.x = w * j, .y = h * i, .w = w, .h = h});
-            }
-            _frames.emplace(
-                std::tuple{animatedDirection, animatedMotion}, std::move(rs));
-        }
-    }
-}
-
-const SDL_Rect* DirectionalSprite::frame() const
-{
-    return &_frames.at({_animatedDirection, _animatedMotion})
-        .at(_currentFrameIndex);
+    _frameIndex = static_cast<uint16_t>(
+        (_frameIndex + advanceFrames(_phase, _clip->framesPerSecond(), delta)) %
+        _clip->frameCount());
 }
 
 void DirectionalSprite::velocity(const XYVector& velocity)
@@ -114,43 +68,70 @@ void DirectionalSprite::velocity(const XYVector& velocity)
 
 void DirectionalSprite::update(double delta)
 {
-    _currentFrameIndex =
-        (_currentFrameIndex + _metronome.ticks(delta)) % _frameCount;
+    _frameIndex = static_cast<uint16_t>(
+        (_frameIndex + advanceFrames(_phase, _clip->framesPerSecond(), delta)) %
+        _clip->frameCount());
 }
 
 View::View(evening::Channel& worldEvents, evening::Channel& controlEvents)
-    : _controlEvents(controlEvents)
+    : _spriteIndex(SpriteIndexCellSize)
+    , _controlEvents(controlEvents)
     , _camera({.pixelsPerUnit = PixelsInUnit, .scale = PixelScale})
 {
-    subscribe<Spawn>(worldEvents, [this] (const auto& spawn) {
-        switch (spawn.objectType) {
-            case ObjectType::Hero:
-                _sprites.emplace(
-                    spawn.entity,
-                    SpriteAndPosition{
-                        .sprite = std::make_unique<DirectionalSprite>(
-                            _heroTexture.raw(), 16, 16, 2),
-                        .position = spawn.location,
-                    });
-                _focusEntity = spawn.entity;
+    subscribe<SpawnBatch>(worldEvents, [this] (const auto& batch) {
+        _sprites.reserve(_sprites.size() + batch.spawns.size());
+        _spriteIndex.reserve(_spriteIndex.size() + batch.spawns.size());
+        for (const auto& spawn : batch.spawns) {
+            switch (spawn.objectType) {
+                case ObjectType::Hero:
+                    addSprite(
+                        spawn.entity,
+                        DirectionalSprite{_animations.clip("hero")},
+                        spawn.location);
+                    break;
+                case ObjectType::Tree:
+                    addSprite(
+                        spawn.entity,
+                        AnimatedSprite{_animations.clip("tree")},
+                        spawn.location);
+                    break;
+            }
+            if (spawn.entity == _focusEntity) {
                 _focusPosition = spawn.location;
-                break;
-            case ObjectType::Tree:
-                _sprites.emplace(
-                    spawn.entity,
-                    SpriteAndPosition{
-                        .sprite = std::make_unique<AnimatedSprite>(
-                            _treeTexture.raw(), 8, 16),
-                        .position = spawn.location,
-                    });
-                break;
+            }
+        }
+    });
+
+    // Follow the entity the world streams around, not just any hero, or
+    // regions would unload under the camera
+    subscribe<Focus>(worldEvents, [this] (const auto& focus) {
+        _focusEntity = focus.entity;
+        if (const auto* spriteAndPosition = _sprites.find(focus.entity)) {
+            _focusPosition = spriteAndPosition->position;
         }
     });
 
+    subscribe<Despawn>(worldEvents, [this] (const auto& despawn) {
+        if (auto* spriteAndPosition = _sprites.find(despawn.entity)) {
+            _spriteIndex.remove(spriteAndPosition->proxy);
+            _sprites.erase(despawn.entity);
+        }
+        if (despawn.entity == _focusEntity) {
+            _focusEntity.reset();
+        }
+    });
+
+    subscribe<InputApplied>(worldEvents, [this] (const auto& applied) {
+        _appliedInputs.push_back(applied.timestamp);
+    });
+
     subscribe<Move>(worldEvents, [this] (const auto& move) {
-        if (auto it = _sprites.find(move.entity); it != _sprites.end()) {
-            it->second.position = move.location;
-            it->second.sprite->velocity(move.velocity);
+        if (auto* spriteAndPosition = _sprites.find(move.entity)) {
+            spriteAndPosition->position = move.location;
+            std::visit([&move] (auto& sprite) {
+                sprite.velocity(move.velocity);
+            }, spriteAndPosition->sprite);
+            _spriteIndex.move(spriteAndPosition->proxy, move.location);
         }
 
         if (move.entity == _focusEntity) {
@@ -158,8 +139,19 @@ View::View(evening::Channel& worldEvents, evening::Channel& controlEvents)
         }
     });
 
-    sdlCheck(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS));
+    // Assets are decoded on background threads while SDL sets up the window
+    // and the renderer; only the texture upload has to wait for the renderer
     check(IMG_Init(IMG_INIT_PNG) == IMG_INIT_PNG);
+    _showProfilerOverlay = config().profilerOverlay;
+    enableProfiling(config().profile || _showProfilerOverlay);
+
+    auto loader = AssetLoader{config().assetThreads > 0 ?
+        config().assetThreads : AssetLoader::defaultThreadCount()};
+    _atlas = Atlas{loader, SOURCE_ROOT / "assets", BINARY_ROOT / "atlas-cache"};
+    startupPhase("asset loading queued");
+
+    sdlCheck(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS));
+    startupPhase("SDL initialized");
 
     _window = sdlCheck(SDL_CreateWindow(
         config().windowTitle.c_str(),
@@ -168,17 +160,40 @@ View::View(evening::Channel& worldEvents, evening::Channel& controlEvents)
         config().windowWidth,
         config().windowHeight,
         SDL_WINDOW_RESIZABLE));
+    startupPhase("window created");
 
     _camera.screenSize = {config().windowWidth, config().windowHeight};
+    _nativeResolution = config().nativeResolution;
+    _snapCamera = config().snapCamera;
 
     _renderer = sdlCheck(SDL_CreateRenderer(
         _window,
-        0,
-        SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC));
-
-    _heroTexture = Texture(_renderer, SOURCE_ROOT / "assets" / "hero.png");
-    _treeTexture = Texture(_renderer, SOURCE_ROOT / "assets"/ "tree.png");
-    _grassTexture = Texture(_renderer, SOURCE_ROOT / "assets" / "grass.png");
+        -1,
+        (config().softwareRenderer ?
+            SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED) |
+        SDL_RENDERER_TARGETTEXTURE |
+        (presentsWithVsync(parsePacingMode(config().pacing)) ?
+            SDL_RENDERER_PRESENTVSYNC : 0)));
+    _batch = SpriteBatch{_renderer, config().batchSprites};
+    aggregateRenderErrors(config().aggregateRenderErrors);
+    startupPhase("renderer created");
+
+    _atlas.upload(_renderer, loader);
+    startupPhase(_atlas.loadedFromCache() ?
+        "atlas uploaded (cached)" : "atlas decoded, packed and uploaded");
+
+    _animations.add("hero", AnimationClip::directional(
+        _atlas.texture("hero"), _atlas.region("hero").rect, 16, 16, 2));
+    _animations.add("tree", AnimationClip::strip(
+        _atlas.texture("tree"), _atlas.region("tree").rect, 8, 16));
+
+    const auto& grass = _atlas.region("grass");
+    _ground = Tilemap{
+        _renderer,
+        _atlas.page(grass.page),
+        grass.rect,
+        grass.rect.h,
+        PixelsInUnit};
 }
 
 View::~View()
@@ -192,47 +207,66 @@ View::~View()
 
 bool View::processEvents()
 {
+    auto zone = ProfileZone{"View::processEvents"};
+    if (_inputEvents) {
+        while (const auto* e = _inputEvents->front()) {
+            const auto event = *e;
+            _inputEvents->pop();
+            if (!handleEvent(event)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     for (auto e = SDL_Event{}; SDL_PollEvent(&e); ) {
-        if (e.type == SDL_QUIT) {
+        if (!handleEvent(e)) {
             return false;
-        } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_q &&
-                (e.key.keysym.mod & (KMOD_CTRL | KMOD_ALT | KMOD_SHIFT)) == 0 &&
-                e.key.repeat == 0) {
-            return false;
-        } else if ((e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) &&
-                e.key.repeat == 0) {
-
-            if (e.key.keysym.sym == SDLK_a) {
-                _controller.leftPressed = (e.type == SDL_KEYDOWN);
-                _controlEvents.push(_controller.control());
-            } else if (e.key.keysym.sym == SDLK_d) {
-                _controller.rightPressed = (e.type == SDL_KEYDOWN);
-                _controlEvents.push(_controller.control());
-            } else if (e.key.keysym.sym == SDLK_w) {
-                _controller.upPressed = (e.type == SDL_KEYDOWN);
-                _controlEvents.push(_controller.control());
-            } else if (e.key.keysym.sym == SDLK_s) {
-                _controller.downPressed = (e.type == SDL_KEYDOWN);
-                _controlEvents.push(_controller.control());
-            } else if (e.type == SDL_KEYDOWN &&
-                    e.key.keysym.sym == SDLK_RETURN &&
-                    (e.key.keysym.mod & (SDLK_LALT | SDLK_RALT))) {
-            }
-        } else if (e.type == SDL_WINDOWEVENT &&
-                e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-            _camera.screenSize = {e.window.data1, e.window.data2};
         }
     }
     return true;
 }
 
-void View::update(double delta)
+bool View::handleEvent(const SDL_Event& e)
 {
-    for (auto& [e, spriteAndPosition] : _sprites) {
-        spriteAndPosition.sprite->update(delta);
+    if (e.type == SDL_QUIT) {
+        return false;
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_q &&
+            (e.key.keysym.mod & (KMOD_CTRL | KMOD_ALT | KMOD_SHIFT)) == 0 &&
+            e.key.repeat == 0) {
+        return false;
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3 &&
+            e.key.repeat == 0) {
+        _showProfilerOverlay = !_showProfilerOverlay;
+        if (_showProfilerOverlay) {
+            enableProfiling(true);
+        }
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F9 &&
+            e.key.repeat == 0) {
+        dumpProfile();
+    } else if (_controller.handle(e)) {
+        _controlEvents.push(_controller.control());
+        _controlEvents.push(InputStamp{e.key.timestamp});
+    } else if (e.type == SDL_WINDOWEVENT &&
+            e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        _camera.screenSize = {e.window.data1, e.window.data2};
+    } else if (e.type == SDL_RENDER_TARGETS_RESET ||
+            e.type == SDL_RENDER_DEVICE_RESET) {
+        _ground.invalidate();
+        _sceneTarget.reset();
     }
+    return true;
+}
 
-    if (_focusEntity) {
+void View::update(double delta)
+{
+    auto zone = ProfileZone{"View::update"};
+
+    // Sprite animations are advanced lazily in present(), and only for
+    // sprites that are on screen
+    _time += delta;
+
+    if (_focusEntity && !_cameraFixed) {
         auto v = _focusPosition - _camera.center;
         float distance = length(_camera.center - _focusPosition);
         float advance = 8.f * distance * delta + 1.f * delta;
@@ -246,39 +280,194 @@ void View::update(double delta)
 
 void View::present()
 {
-    sdlCheck(SDL_SetRenderDrawColor(_renderer, 50, 50, 50, 255));
-    sdlCheck(SDL_RenderClear(_renderer));
+    auto zone = ProfileZone{"View::present"};
 
-    layTexture(_grassTexture);
+    drawFrame();
 
-    for (const auto& [e, spriteAndPosition] : _sprites) {
-        const auto& [sprite, position] = spriteAndPosition;
-        SDL_FRect targetRect =
-            _camera.rect(position, sprite->width(), sprite->height());
-        sdlCheck(SDL_RenderCopyF(
-            _renderer, sprite->texture(), sprite->frame(), &targetRect));
+    _presentStartTime = std::chrono::steady_clock::now();
+    SDL_RenderPresent(_renderer);
+    reportRenderErrors();
+
+    // Timestamps are those of SDL events, in milliseconds since SDL_Init
+    const auto now = SDL_GetTicks();
+    for (auto timestamp : _appliedInputs) {
+        _inputLatency.add(now - timestamp);
+    }
+    _appliedInputs.clear();
+    _profilerOverlay.frame();
+
+    if (!_presentedFirstFrame) {
+        _presentedFirstFrame = true;
+        startupPhase("first frame presented");
+        if (config().reportStartup) {
+            reportStartup(std::cout);
+        }
     }
+}
 
-    SDL_RenderPresent(_renderer);
+SurfacePtr View::capture()
+{
+    drawFrame();
+
+    int width = 0;
+    int height = 0;
+    sdlCheck(SDL_GetRendererOutputSize(_renderer, &width, &height));
+    auto image = SurfacePtr{
+        sdlCheck(SDL_CreateRGBSurfaceWithFormat(
+            0, width, height, 32, SDL_PIXELFORMAT_RGBA32)),
+        SDL_FreeSurface};
+    sdlCheck(SDL_RenderReadPixels(
+        _renderer,
+        nullptr,
+        SDL_PIXELFORMAT_RGBA32,
+        image->pixels,
+        image->pitch));
+    return image;
 }
 
-void View::layTexture(const Texture& texture)
+void View::lookAt(const XYVector& center)
 {
-    auto r = SDL_FRect{
-        .x = 0.f,
-        .y = 0.f,
-        .w = 1.f * texture.width() * PixelScale,
-        .h = 1.f * texture.height() * PixelScale
+    _cameraFixed = true;
+    _camera.center = center;
+}
+
+void View::drawFrame()
+{
+    sdlCheck(SDL_SetRenderDrawColor(_renderer, 50, 50, 50, 255));
+    if (_nativeResolution) {
+        drawNative();
+    } else {
+        sdlCheck(SDL_RenderClear(_renderer));
+        drawScene(_snapCamera ? _camera.snapped() : _camera);
+    }
+
+    if (_showProfilerOverlay) {
+        _profilerOverlay.draw(_renderer);
+    }
+}
+
+void View::drawScene(const Camera& camera)
+{
+    _ground.draw(camera, _batch);
+
+    _spriteIndex.query(
+        camera.center - camera.halfView(),
+        camera.center + camera.halfView(),
+        _visibleSprites);
+
+    // Sprites overlap, so draw them in entity order, as the full scan did
+    std::sort(
+        _visibleSprites.begin(),
+        _visibleSprites.end(),
+        [this] (auto a, auto b) {
+            return _spriteIndex.entity(a) < _spriteIndex.entity(b);
+        });
+
+    for (auto proxy : _visibleSprites) {
+        auto& spriteAndPosition = _sprites.at(_spriteIndex.entity(proxy));
+        std::visit([this, &camera, &spriteAndPosition] (auto& sprite) {
+            SDL_FRect targetRect = camera.rect(
+                spriteAndPosition.position, sprite.width(), sprite.height());
+            if (targetRect.x >= camera.screenSize.x ||
+                    targetRect.y >= camera.screenSize.y ||
+                    targetRect.x + targetRect.w <= 0 ||
+                    targetRect.y + targetRect.h <= 0) {
+                return;
+            }
+
+            sprite.update(_time - spriteAndPosition.animationTime);
+            spriteAndPosition.animationTime = _time;
+            _batch.draw(sprite.texture(), sprite.frame(), targetRect);
+        }, spriteAndPosition.sprite);
+    }
+    _batch.flush();
+}
+
+void View::drawNative()
+{
+    // One target pixel per art pixel, and enough of them to cover the window.
+    // With an even size the camera center falls between two pixels, so a
+    // snapped camera puts the art on whole target pixels.
+    auto camera = _camera;
+    camera.scale = 1;
+    camera.screenSize = {
+        ((_camera.screenSize.x + PixelScale - 1) / PixelScale + 1) & ~1,
+        ((_camera.screenSize.y + PixelScale - 1) / PixelScale + 1) & ~1,
     };
-    const float startx = (-texture.width() - std::fmod(_camera.center.x * PixelsInUnit, texture.width())) * PixelScale;
-    const float starty = (-texture.height() + std::fmod(_camera.center.y * PixelsInUnit, texture.height())) * PixelScale;
-    for (r.x = startx; r.x < _camera.screenSize.x; r.x += r.w) {
-        for (r.y = starty; r.y < _camera.screenSize.y; r.y += r.h) {
-            sdlCheck(SDL_RenderCopyF(
-                _renderer,
-                texture.raw(),
-                nullptr,
-                &r));
-        }
+    if (_snapCamera) {
+        camera = camera.snapped();
+    }
+
+    if (!_sceneTarget || _sceneTargetSize.x != camera.screenSize.x ||
+            _sceneTargetSize.y != camera.screenSize.y) {
+        _sceneTarget.reset(sdlCheck(SDL_CreateTexture(
+            _renderer,
+            SDL_PIXELFORMAT_RGBA32,
+            SDL_TEXTUREACCESS_TARGET,
+            camera.screenSize.x,
+            camera.screenSize.y)));
+        sdlCheck(SDL_SetTextureScaleMode(
+            _sceneTarget.get(), SDL_ScaleModeNearest));
+        _sceneTargetSize = camera.screenSize;
+    }
+
+    sdlCheck(SDL_SetRenderTarget(_renderer, _sceneTarget.get()));
+    sdlCheck(SDL_RenderClear(_renderer));
+    drawScene(camera);
+    sdlCheck(SDL_SetRenderTarget(_renderer, nullptr));
+
+    // The scaled-up target overhangs the window evenly on both sides, so the
+    // window needs no clear of its own
+    const auto target = SDL_Rect{
+        .x = (_camera.screenSize.x - camera.screenSize.x * PixelScale) / 2,
+        .y = (_camera.screenSize.y - camera.screenSize.y * PixelScale) / 2,
+        .w = camera.screenSize.x * PixelScale,
+        .h = camera.screenSize.y * PixelScale,
+    };
+    sdlCheck(SDL_RenderCopy(_renderer, _sceneTarget.get(), nullptr, &target));
+}
+
+int View::refreshRate() const
+{
+    const int display = SDL_GetWindowDisplayIndex(_window);
+    auto mode = SDL_DisplayMode{};
+    if (display < 0 || SDL_GetCurrentDisplayMode(display, &mode) != 0 ||
+            mode.refresh_rate <= 0) {
+        return 60;
+    }
+    return mode.refresh_rate;
+}
+
+void View::addSprite(
+    thing::Entity entity, AnySprite sprite, const XYVector& position)
+{
+    const float radius = std::visit([] (const auto& s) {
+        return std::hypot(s.width(), s.height()) / (2.f * PixelsInUnit);
+    }, sprite);
+    _sprites.insert(
+        entity,
+        SpriteAndPosition{
+            .sprite = std::move(sprite),
+            .position = position,
+            .proxy = _spriteIndex.insert(entity, position, radius),
+            .animationTime = _time,
+        });
+}
+
+void View::dumpProfile()
+{
+    if (!profilingEnabled()) {
+        std::cerr << "profiling is off; enable it with BUZZ_PROFILE=1 or F3\n";
+        return;
     }
+
+    auto records = std::vector<ProfileRecord>{};
+    captureProfile(records);
+
+    const auto path = std::filesystem::path{"buzz-trace.json"};
+    auto output = std::ofstream{path};
+    writeChromeTrace(output, records);
+    check(output.good());
+    std::cout << "wrote " << records.size() << " zones to " <<
+        std::filesystem::absolute(path).string() << "\n";
 }
@@ -1,161 +1,168 @@
 #pragma once
 
+#include "animation.hpp"
+#include "asset-loader.hpp"
+#include "atlas.hpp"
+#include "camera.hpp"
+#include "entity-map.hpp"
+#include "input-thread.hpp"
+#include "keyboard-controller.hpp"
+#include "latency-stats.hpp"
+#include "profiler-overlay.hpp"
 #include "sdl.hpp"
+#include "spatial-hash.hpp"
+#include "texture.hpp"
+#include "sprite-batch.hpp"
+#include "tilemap.hpp"
 #include "types.hpp"
 
 #include "evening.hpp"
-#include "tempo.hpp"
 #include "thing.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
-#include <map>
 #include <memory>
 #include <optional>
-#include <tuple>
+#include <variant>
 #include <vector>
 
-class Texture final {
+class AnimatedSprite {
 public:
-    Texture() {}
-    Texture(SDL_Renderer* renderer, const std::filesystem::path& pathToImageFile);
+    explicit AnimatedSprite(const AnimationClip& clip) : _clip(&clip) {}
 
-    SDL_Texture* raw() const;
-    const int width() const;
-    const int height() const;
-
-private:
-    std::unique_ptr<SDL_Texture, void(*)(SDL_Texture*)> _sdlTexture {nullptr, SDL_DestroyTexture};
-    int _width = 0;
-    int _height = 0;
-
-    friend class View;
-};
-
-class Sprite {
-public:
-    virtual ~Sprite() {}
-
-    virtual SDL_Texture* texture() const = 0;
-    virtual int width() const = 0;
-    virtual int height() const = 0;
-    virtual const SDL_Rect* frame() const = 0;
-
-    virtual void velocity(const XYVector& velocity) {}
-    virtual void update(double delta) {}
-};
-
-class AnimatedSprite : public Sprite {
-public:
-    AnimatedSprite(SDL_Texture* texture, int w, int h, int frames = 1);
-
-    SDL_Texture* texture() const override { return _texture; }
-    int width() const override { return _width; }
-    int height() const override { return _height; }
-    const SDL_Rect* frame() const override { return &_frames.at(_currentFrameIndex); }
+    SDL_Texture* texture() const { return _clip->texture(); }
+    int width() const { return _clip->width(); }
+    int height() const { return _clip->height(); }
+    const SDL_Rect* frame() const
+    {
+        return &_clip->frame(
+            AnimatedDirection::Down, AnimatedMotion::Stand, _frameIndex);
+    }
 
-    void update(double delta) override;
+    void velocity(const XYVector&) {}
+    void update(double delta);
 
 private:
-    SDL_Texture* _texture = nullptr;
-    int _width = 0;
-    int _height = 0;
-    std::vector<SDL_Rect> _frames;
-    size_t _currentFrameIndex = 0;
-    tempo::Metronome _metronome {3};
+    const AnimationClip* _clip = nullptr;
+    float _phase = 0.f; // time into the current frame, in frames
+    uint16_t _frameIndex = 0;
 };
 
-class DirectionalSprite : public Sprite {
+class DirectionalSprite {
 public:
-    DirectionalSprite(SDL_Texture* texture, int w, int h, int frames = 1);
+    explicit DirectionalSprite(const AnimationClip& clip) : _clip(&clip) {}
 
-    SDL_Texture* texture() const override { return _texture; }
-    int width() const override { return _width; }
-    int height() const override { return _height; }
-    const SDL_Rect* frame() const override;
+    SDL_Texture* texture() const { return _clip->texture(); }
+    int width() const { return _clip->width(); }
+    int height() const { return _clip->height(); }
+    const SDL_Rect* frame() const
+    {
+        return &_clip->frame(_animatedDirection, _animatedMotion, _frameIndex);
+    }
 
-    void velocity(const XYVector& velocity) override;
-    void update(double delta) override;
+    void velocity(const XYVector& velocity);
+    void update(double delta);
 
 private:
-    enum class AnimatedDirection {Down, Up, Left, Right};
-    enum class AnimatedMotion {Stand, Walk};
-
     static constexpr float _minWalkSpeed = 3.f;
 
-    SDL_Texture* _texture = nullptr;
-    int _width = 0;
-    int _height = 0;
-
-    std::map<
-        std::tuple<AnimatedDirection, AnimatedMotion>,
-        std::vector<SDL_Rect>> _frames;
-    size_t _frameCount = 0;
-    size_t _currentFrameIndex = 0;
+    const AnimationClip* _clip = nullptr;
+    float _phase = 0.f;
+    uint16_t _frameIndex = 0;
     AnimatedDirection _animatedDirection = AnimatedDirection::Down;
     AnimatedMotion _animatedMotion = AnimatedMotion::Stand;
-    tempo::Metronome _metronome {3};
-};
-
-struct Camera {
-    SDL_FRect rect(const XYVector& position, int spriteWidth, int spriteHeight)
-    {
-        return {
-            .x = (position.x - center.x) * pixelsPerUnit * scale + screenSize.x / 2.f - spriteWidth * scale / 2.f,
-            .y = (center.y - position.y) * pixelsPerUnit * scale + screenSize.y / 2.f - spriteHeight * scale / 2.f,
-            .w = 1.f * spriteWidth * scale,
-            .h = 1.f * spriteHeight * scale,
-        };
-    }
-
-    int pixelsPerUnit = 0;
-    int scale = 0;
-    ScreenVector screenSize;
-    XYVector center;
 };
 
-struct KeyboardControllerState {
-    bool leftPressed = false;
-    bool rightPressed = false;
-    bool upPressed = false;
-    bool downPressed = false;
-
-    XYVector control() const
-    {
-        return XYVector{
-            1.f * rightPressed - leftPressed,
-            1.f * upPressed - downPressed};
-    }
-};
+// Closed set of sprite kinds, so sprites can be stored by value and called
+// without virtual dispatch
+using AnySprite = std::variant<AnimatedSprite, DirectionalSprite>;
 
 class View final : public evening::Subscriber {
 public:
     View(evening::Channel& worldEvents, evening::Channel& controlEvents);
     ~View();
 
+    // Take events from an input thread instead of polling SDL. Control keys
+    // are then handled by the input thread.
+    void readEvents(InputEventRing& events) { _inputEvents = &events; }
+
     bool processEvents();
     void update(double delta);
     void present();
 
+    // Draws a frame as present() would, and reads it back instead of showing
+    // it. Reading back is slow with anything but the software renderer.
+    SurfacePtr capture();
+
+    // Point the camera at a fixed place instead of following the hero
+    void lookAt(const XYVector& center);
+
+    // Draw the scene at the art's own resolution into an offscreen target,
+    // and scale that up to the window with a single nearest-neighbour copy
+    void renderAtNativeResolution(bool enabled) { _nativeResolution = enabled; }
+
+    // Of the display the window is on; 60 if SDL does not know
+    int refreshRate() const;
+
+    // When the last present() handed the frame to SDL_RenderPresent
+    std::chrono::steady_clock::time_point presentStartTime() const
+    {
+        return _presentStartTime;
+    }
+
+    // From control key events to the first present showing their effect
+    const LatencyStats& inputLatency() const { return _inputLatency; }
+
 private:
     struct SpriteAndPosition {
-        std::unique_ptr<Sprite> sprite;
+        AnySprite sprite;
         XYVector position;
+        SpatialHash::Handle proxy = 0;
+        double animationTime = 0.0;
     };
 
-    void layTexture(const Texture& texture);
+    bool handleEvent(const SDL_Event& e);
+    void drawFrame();
+    void drawScene(const Camera& camera);
+    void drawNative();
+    void addSprite(
+        thing::Entity entity, AnySprite sprite, const XYVector& position);
+    void dumpProfile();
 
     SDL_Window* _window = nullptr;
     SDL_Renderer* _renderer = nullptr;
+    SpriteBatch _batch;
+
+    Atlas _atlas;
+    AnimationLibrary _animations;
+
+    Tilemap _ground;
+
+    std::unique_ptr<SDL_Texture, void(*)(SDL_Texture*)> _sceneTarget {
+        nullptr, SDL_DestroyTexture};
+    ScreenVector _sceneTargetSize;
+    bool _nativeResolution = false;
+    bool _snapCamera = false;
+
+    EntityMap<SpriteAndPosition> _sprites;
+    SpatialHash _spriteIndex;
+    std::vector<SpatialHash::Handle> _visibleSprites;
+    double _time = 0.0;
+    bool _presentedFirstFrame = false;
+    std::chrono::steady_clock::time_point _presentStartTime;
 
-    Texture _heroTexture;
-    Texture _treeTexture;
-    Texture _grassTexture;
+    std::vector<uint32_t> _appliedInputs;
+    LatencyStats _inputLatency;
 
-    std::map<thing::Entity, SpriteAndPosition> _sprites;
+    ProfilerOverlay _profilerOverlay;
+    bool _showProfilerOverlay = false;
 
     evening::Channel& _controlEvents;
     Camera _camera;
+    bool _cameraFixed = false;
     KeyboardControllerState _controller;
+    InputEventRing* _inputEvents = nullptr;
     std::optional<thing::Entity> _focusEntity;
     XYVector _focusPosition;
 };
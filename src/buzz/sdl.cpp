@@ -1,8 +1,64 @@
 #include "sdl.hpp"
 
-void sdlCheck(int code, std::source_location location)
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct RenderError {
+    std::source_location location;
+    std::string message;
+    int count = 0;
+};
+
+// Render calls are only made from the render thread
+bool renderErrorsAggregated = false;
+std::vector<RenderError> renderErrors;
+
+bool sameSite(const std::source_location& a, const std::source_location& b)
+{
+    return a.line() == b.line() && a.column() == b.column() &&
+        std::strcmp(a.file_name(), b.file_name()) == 0;
+}
+
+} // namespace
+
+void throwSdlError(std::source_location location)
+{
+    throw Error{location} << SDL_GetError();
+}
+
+void renderFailure(std::source_location location)
+{
+    if (!renderErrorsAggregated) {
+        throwSdlError(location);
+    }
+
+    for (auto& error : renderErrors) {
+        if (sameSite(error.location, location)) {
+            error.count++;
+            return;
+        }
+    }
+    renderErrors.push_back(RenderError{
+        .location = location,
+        .message = SDL_GetError(),
+        .count = 1,
+    });
+}
+
+void aggregateRenderErrors(bool enabled)
+{
+    renderErrorsAggregated = enabled;
+}
+
+void reportRenderErrors()
 {
-    if (code != 0) {
-        throw Error{std::move(location)} << SDL_GetError();
+    for (const auto& error : renderErrors) {
+        std::cerr << (Error{error.location} << error.message).what() <<
+            " (failed " << error.count << " times this frame)\n";
     }
+    renderErrors.clear();
 }
@@ -7,13 +7,38 @@
 
 #include <utility>
 
-void sdlCheck(int code, std::source_location location = std::source_location::current());
+[[noreturn]] void throwSdlError(std::source_location location);
+
+inline void sdlCheck(
+    int code, std::source_location location = std::source_location::current())
+{
+    if (code != 0) [[unlikely]] {
+        throwSdlError(location);
+    }
+}
 
 template <class T>
 T* sdlCheck(T* ptr, std::source_location location = std::source_location::current())
 {
-    if (!ptr) {
-        throw Error{std::move(location)} << SDL_GetError();
+    if (!ptr) [[unlikely]] {
+        throwSdlError(location);
     }
     return ptr;
 }
+
+// For render calls made many times per frame, such as sprite draws. While
+// render errors are aggregated, a failure is counted against its call site
+// instead of thrown, and reportRenderErrors() prints one line per site, so a
+// bad texture costs a log line per frame rather than thousands of throws.
+void renderFailure(std::source_location location);
+
+inline void renderCheck(
+    int code, std::source_location location = std::source_location::current())
+{
+    if (code != 0) [[unlikely]] {
+        renderFailure(location);
+    }
+}
+
+void aggregateRenderErrors(bool enabled);
+void reportRenderErrors();
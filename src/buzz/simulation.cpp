@@ -0,0 +1,206 @@
+#include "simulation.hpp"
+
+#include "arena.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+Simulation::Simulation(
+        evening::Channel& controlEvents, int ticksPerSecond, int maxCatchUpTicks)
+    : _world(_worldEvents, _controlEvents)
+    , _step(ticksPerSecond, maxCatchUpTicks)
+{
+    subscribe<XYVector>(controlEvents, [this] (const auto& control) {
+        auto lock = std::scoped_lock{_mailboxMutex};
+        _controls.push_back(control);
+    });
+
+    subscribe<InputStamp>(controlEvents, [this] (const auto& stamp) {
+        auto lock = std::scoped_lock{_mailboxMutex};
+        _inputStamps.push_back(stamp);
+    });
+
+    subscribe<SpawnBatch>(_worldEvents, [this] (const auto& batch) {
+        auto lock = std::scoped_lock{_mailboxMutex};
+        _spawns.push_back(batch);
+    });
+
+    subscribe<Despawn>(_worldEvents, [this] (const auto& despawn) {
+        _states.erase(despawn.entity);
+        auto lock = std::scoped_lock{_mailboxMutex};
+        _despawns.push_back(despawn);
+    });
+
+    subscribe<Focus>(_worldEvents, [this] (const auto& focus) {
+        auto lock = std::scoped_lock{_mailboxMutex};
+        _focus = focus;
+    });
+
+    subscribe<InputApplied>(_worldEvents, [this] (const auto& applied) {
+        auto lock = std::scoped_lock{_mailboxMutex};
+        _appliedInputs.push_back({_tick, applied});
+    });
+
+    subscribe<Move>(_worldEvents, [this] (const auto& move) {
+        auto* state = _states.find(move.entity);
+        if (!state) {
+            state = &_states.insert(move.entity, EntityState{
+                .entity = move.entity,
+                .location = move.location,
+            });
+        }
+        state->previousLocation = state->location;
+        state->location = move.location;
+        state->velocity = move.velocity;
+        state->tick = _tick;
+    });
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start()
+{
+    _worldEvents.deliver();
+    _step.reset();
+    _thread = std::jthread{[this] (std::stop_token stopToken) {
+        run(stopToken);
+    }};
+}
+
+void Simulation::stop()
+{
+    if (_thread.joinable()) {
+        _thread.request_stop();
+        _thread.join();
+    }
+}
+
+void Simulation::deliver(evening::Channel& worldEvents)
+{
+    {
+        auto lock = std::scoped_lock{_mailboxMutex};
+        for (auto& batch : _spawns) {
+            worldEvents.push(std::move(batch));
+        }
+        _spawns.clear();
+        for (const auto& despawn : _despawns) {
+            worldEvents.push(despawn);
+        }
+        _despawns.clear();
+        if (_focus) {
+            worldEvents.push(*_focus);
+            _focus.reset();
+        }
+    }
+
+    bool fresh = _snapshots.acquire();
+    const auto& snapshot = _snapshots.front();
+
+    // Inputs count as shown once the snapshot with their tick is
+    {
+        auto lock = std::scoped_lock{_mailboxMutex};
+        auto shown = std::partition_point(
+            _appliedInputs.begin(),
+            _appliedInputs.end(),
+            [&snapshot] (const auto& applied) {
+                return applied.first <= snapshot.tick;
+            });
+        for (auto it = _appliedInputs.begin(); it != shown; ++it) {
+            worldEvents.push(it->second);
+        }
+        _appliedInputs.erase(_appliedInputs.begin(), shown);
+    }
+
+    // Render one tick behind the simulation: the latest state is reached
+    // when a whole tick has passed since it was simulated
+    const float alpha = static_cast<float>(std::clamp(
+        std::chrono::duration<double>{
+            FixedStep::Clock::now() - snapshot.time}.count() / _step.delta(),
+        0.0,
+        1.0));
+
+    for (const auto& state : snapshot.entities) {
+        bool moving = state.previousLocation.x != state.location.x ||
+            state.previousLocation.y != state.location.y;
+        if (!fresh && !moving) {
+            continue;
+        }
+
+        worldEvents.push(Move{
+            .entity = state.entity,
+            .location = state.previousLocation +
+                (state.location - state.previousLocation) * alpha,
+            .velocity = state.velocity,
+        });
+    }
+}
+
+void Simulation::run(std::stop_token stopToken)
+{
+    setProfileThreadName("simulation");
+
+    while (!stopToken.stop_requested()) {
+        frameArena().reset();
+        {
+            auto lock = std::scoped_lock{_mailboxMutex};
+            for (const auto& control : _controls) {
+                _controlEvents.push(control);
+            }
+            _controls.clear();
+            for (const auto& stamp : _inputStamps) {
+                _controlEvents.push(stamp);
+            }
+            _inputStamps.clear();
+        }
+        _controlEvents.deliver();
+
+        int ticks = _step();
+        if (ticks == 0) {
+            std::this_thread::sleep_until(_step.nextTickTime());
+            continue;
+        }
+
+        for (int i = 0; i < ticks; i++) {
+            if (_inputControls) {
+                const auto tickTime = _step.lastTickTime() -
+                    _step.tickDuration() * (ticks - 1 - i);
+                while (const auto* control = _inputControls->front()) {
+                    if (control->time > tickTime) {
+                        break;
+                    }
+                    _controlEvents.push(control->control);
+                    _controlEvents.push(InputStamp{control->timestamp});
+                    _inputControls->pop();
+                }
+                _controlEvents.deliver();
+            }
+
+            _tick++;
+            _world.update(_step.delta());
+            _world.publish();
+            auto zone = ProfileZone{"worldEvents.deliver"};
+            _worldEvents.deliver();
+        }
+        auto zone = ProfileZone{"Simulation::writeSnapshot"};
+        writeSnapshot();
+    }
+}
+
+void Simulation::writeSnapshot()
+{
+    auto& snapshot = _snapshots.back();
+    snapshot.tick = _tick;
+    snapshot.time = _step.lastTickTime();
+    snapshot.entities.clear();
+    for (const auto& state : _states) {
+        auto& s = snapshot.entities.emplace_back(state);
+        if (state.tick != _tick) {
+            s.previousLocation = state.location;
+        }
+    }
+    _snapshots.publish();
+}
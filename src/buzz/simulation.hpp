@@ -0,0 +1,82 @@
+#pragma once
+
+#include "entity-map.hpp"
+#include "events.hpp"
+#include "fixed-step.hpp"
+#include "input-thread.hpp"
+#include "triple-buffer.hpp"
+#include "world.hpp"
+
+#include "evening.hpp"
+#include "thing.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Runs World at a fixed rate on its own thread. After each batch of ticks,
+// positions of moving entities are published as a snapshot holding both the
+// previous and the latest tick state, so the render thread can interpolate.
+class Simulation : public evening::Subscriber {
+public:
+    Simulation(
+        evening::Channel& controlEvents, int ticksPerSecond, int maxCatchUpTicks);
+    ~Simulation();
+
+    // Only safe to use before start()
+    World& world() { return _world; }
+
+    // Also take timestamped controls from an input thread. Each is applied
+    // on the first tick scheduled at or after its time. Call before start().
+    void readControls(ControlRing& controls) { _inputControls = &controls; }
+
+    void start();
+    void stop();
+
+    // Called on the render thread: pushes new SpawnBatch, Despawn and Focus
+    // events, Move events interpolated between the last two simulated states,
+    // and InputApplied for the inputs those states reflect, to the channel
+    void deliver(evening::Channel& worldEvents);
+
+private:
+    struct EntityState {
+        thing::Entity entity;
+        XYVector previousLocation;
+        XYVector location;
+        XYVector velocity;
+        uint64_t tick = 0;
+    };
+
+    struct Snapshot {
+        uint64_t tick = 0;
+        FixedStep::Clock::time_point time;
+        std::vector<EntityState> entities;
+    };
+
+    void run(std::stop_token stopToken);
+    void writeSnapshot();
+
+    evening::Channel _worldEvents;
+    evening::Channel _controlEvents;
+    World _world;
+    FixedStep _step;
+    uint64_t _tick = 0;
+
+    EntityMap<EntityState> _states;
+    TripleBuffer<Snapshot> _snapshots;
+
+    std::mutex _mailboxMutex;
+    std::vector<SpawnBatch> _spawns;
+    std::vector<Despawn> _despawns;
+    std::optional<Focus> _focus;
+    std::vector<XYVector> _controls;
+    std::vector<InputStamp> _inputStamps;
+    std::vector<std::pair<uint64_t, InputApplied>> _appliedInputs;
+    ControlRing* _inputControls = nullptr;
+
+    std::jthread _thread;
+};
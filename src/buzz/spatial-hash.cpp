@@ -0,0 +1,185 @@
+#include "spatial-hash.hpp"
+
+#include "error.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cellSize)
+    : _cellSize(cellSize)
+{
+    check(cellSize > 0);
+}
+
+void SpatialHash::reserve(size_t proxies)
+{
+    _proxies.reserve(proxies);
+    // A proxy smaller than a cell touches up to four cells, which it mostly
+    // shares with neighbours
+    _cells.reserve(proxies * 2);
+}
+
+SpatialHash::Handle SpatialHash::insert(
+    thing::Entity entity, const XYVector& position, float radius)
+{
+    return insert(entity, position, radius, _nextOrder++);
+}
+
+SpatialHash::Handle SpatialHash::insert(
+    thing::Entity entity,
+    const XYVector& position,
+    float radius,
+    uint64_t order)
+{
+    Handle handle;
+    if (!_freeHandles.empty()) {
+        handle = _freeHandles.back();
+        _freeHandles.pop_back();
+    } else {
+        handle = static_cast<Handle>(_proxies.size());
+        _proxies.emplace_back();
+    }
+
+    auto& proxy = _proxies.at(handle);
+    proxy = Proxy{
+        .entity = entity,
+        .order = order,
+        .position = position,
+        .radius = radius,
+        .cells = cellRange(
+            position - XYVector{radius, radius},
+            position + XYVector{radius, radius}),
+    };
+    link(handle, proxy.cells);
+    return handle;
+}
+
+void SpatialHash::remove(Handle handle)
+{
+    auto& proxy = _proxies.at(handle);
+    unlink(handle, proxy.cells);
+    proxy.cells = CellRange{};
+    _freeHandles.push_back(handle);
+}
+
+bool SpatialHash::move(Handle handle, const XYVector& position)
+{
+    auto& proxy = _proxies.at(handle);
+    proxy.position = position;
+    auto cells = cellRange(
+        position - XYVector{proxy.radius, proxy.radius},
+        position + XYVector{proxy.radius, proxy.radius});
+    if (cells == proxy.cells) {
+        return false;
+    }
+
+    unlink(handle, proxy.cells);
+    link(handle, cells);
+    proxy.cells = cells;
+    return true;
+}
+
+void SpatialHash::query(
+    const XYVector& min,
+    const XYVector& max,
+    std::vector<Handle>& result) const
+{
+    result.clear();
+
+    auto cells = cellRange(min, max);
+    for (int x = cells.minX; x <= cells.maxX; x++) {
+        for (int y = cells.minY; y <= cells.maxY; y++) {
+            auto it = _cells.find(cellKey(x, y));
+            if (it == _cells.end()) {
+                continue;
+            }
+            result.insert(result.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [this] (Handle a, Handle b) {
+        return _proxies[a].order < _proxies[b].order;
+    });
+    // Proxies spanning several cells have been collected more than once
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+thing::Entity SpatialHash::entity(Handle handle) const
+{
+    return _proxies.at(handle).entity;
+}
+
+uint64_t SpatialHash::order(Handle handle) const
+{
+    return _proxies.at(handle).order;
+}
+
+const XYVector& SpatialHash::position(Handle handle) const
+{
+    return _proxies.at(handle).position;
+}
+
+float SpatialHash::radius(Handle handle) const
+{
+    return _proxies.at(handle).radius;
+}
+
+SpatialHash::CellRange SpatialHash::cellRange(
+    const XYVector& min, const XYVector& max) const
+{
+    return {
+        .minX = static_cast<int>(std::floor(min.x / _cellSize)),
+        .minY = static_cast<int>(std::floor(min.y / _cellSize)),
+        .maxX = static_cast<int>(std::floor(max.x / _cellSize)),
+        .maxY = static_cast<int>(std::floor(max.y / _cellSize)),
+    };
+}
+
+void SpatialHash::link(Handle handle, const CellRange& cells)
+{
+    for (int x = cells.minX; x <= cells.maxX; x++) {
+        for (int y = cells.minY; y <= cells.maxY; y++) {
+            const auto key = cellKey(x, y);
+            auto it = _cells.find(key);
+            if (it == _cells.end()) {
+                if (_spareCells.empty()) {
+                    it = _cells.try_emplace(key).first;
+                } else {
+                    auto node = std::move(_spareCells.back());
+                    _spareCells.pop_back();
+                    node.key() = key;
+                    it = _cells.insert(std::move(node)).position;
+                }
+            }
+            it->second.push_back(handle);
+        }
+    }
+}
+
+void SpatialHash::unlink(Handle handle, const CellRange& cells)
+{
+    for (int x = cells.minX; x <= cells.maxX; x++) {
+        for (int y = cells.minY; y <= cells.maxY; y++) {
+            auto it = _cells.find(cellKey(x, y));
+            if (it == _cells.end()) {
+                continue;
+            }
+
+            auto& handles = it->second;
+            if (auto h = std::find(handles.begin(), handles.end(), handle);
+                    h != handles.end()) {
+                *h = handles.back();
+                handles.pop_back();
+            }
+            if (handles.empty()) {
+                _spareCells.push_back(_cells.extract(it));
+            }
+        }
+    }
+}
+
+uint64_t SpatialHash::cellKey(int x, int y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+        static_cast<uint32_t>(y);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "types.hpp"
+
+#include "thing.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over world space, stored sparsely in a hash map of cells. Each
+// proxy is a circle, registered in every cell its bounding box touches.
+class SpatialHash {
+public:
+    using Handle = uint32_t;
+
+    explicit SpatialHash(float cellSize);
+
+    // Makes room for this many proxies in total, for bulk inserts
+    void reserve(size_t proxies);
+
+    // Proxies are ordered by insertion, unless given an order explicitly
+    Handle insert(thing::Entity entity, const XYVector& position, float radius);
+    Handle insert(
+        thing::Entity entity,
+        const XYVector& position,
+        float radius,
+        uint64_t order);
+    void remove(Handle handle);
+
+    // Returns true if the proxy has moved to a different set of cells
+    bool move(Handle handle, const XYVector& position);
+
+    // Collects proxies with bounding boxes overlapping the [min, max] box,
+    // sorted by order. Safe to call from several threads at once.
+    void query(
+        const XYVector& min,
+        const XYVector& max,
+        std::vector<Handle>& result) const;
+
+    size_t size() const { return _proxies.size() - _freeHandles.size(); }
+
+    thing::Entity entity(Handle handle) const;
+    uint64_t order(Handle handle) const;
+    const XYVector& position(Handle handle) const;
+    float radius(Handle handle) const;
+
+private:
+    struct CellRange {
+        int minX = 0;
+        int minY = 0;
+        int maxX = -1;
+        int maxY = -1;
+
+        bool operator==(const CellRange&) const = default;
+    };
+
+    struct Proxy {
+        thing::Entity entity;
+        uint64_t order = 0;
+        XYVector position;
+        float radius = 0.f;
+        CellRange cells;
+    };
+
+    CellRange cellRange(const XYVector& min, const XYVector& max) const;
+    void link(Handle handle, const CellRange& cells);
+    void unlink(Handle handle, const CellRange& cells);
+
+    static uint64_t cellKey(int x, int y);
+
+    using Cells = std::unordered_map<uint64_t, std::vector<Handle>>;
+
+    float _cellSize = 1.f;
+    Cells _cells;
+    // Cells that emptied out, kept with their storage to be reused for the
+    // next new cell, so moving proxies around does not go to the heap
+    std::vector<Cells::node_type> _spareCells;
+    std::vector<Proxy> _proxies;
+    std::vector<Handle> _freeHandles;
+    uint64_t _nextOrder = 0;
+};
@@ -0,0 +1,68 @@
+#include "sprite-batch.hpp"
+
+SpriteBatch::SpriteBatch(SDL_Renderer* renderer, bool enabled)
+    : _renderer(renderer)
+    , _enabled(enabled)
+{ }
+
+void SpriteBatch::draw(
+    SDL_Texture* texture, const SDL_Rect* source, const SDL_FRect& target)
+{
+    if (!_enabled) {
+        renderCheck(SDL_RenderCopyF(_renderer, texture, source, &target));
+        return;
+    }
+
+    if (texture != _texture) {
+        int w = 0;
+        int h = 0;
+        // A bad texture is counted with the other render errors, and its
+        // quad dropped, rather than failing the whole frame
+        const int queried = SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+        renderCheck(queried);
+        if (queried != 0) {
+            return;
+        }
+        flush();
+        _texture = texture;
+        _textureWidth = static_cast<float>(w);
+        _textureHeight = static_cast<float>(h);
+    }
+
+    const auto s = source ? *source : SDL_Rect{
+        .x = 0, .y = 0,
+        .w = static_cast<int>(_textureWidth),
+        .h = static_cast<int>(_textureHeight),
+    };
+    const float u0 = s.x / _textureWidth;
+    const float v0 = s.y / _textureHeight;
+    const float u1 = (s.x + s.w) / _textureWidth;
+    const float v1 = (s.y + s.h) / _textureHeight;
+    const auto white = SDL_Color{255, 255, 255, 255};
+
+    const int base = static_cast<int>(_vertices.size());
+    _vertices.push_back({{target.x, target.y}, white, {u0, v0}});
+    _vertices.push_back({{target.x + target.w, target.y}, white, {u1, v0}});
+    _vertices.push_back(
+        {{target.x + target.w, target.y + target.h}, white, {u1, v1}});
+    _vertices.push_back({{target.x, target.y + target.h}, white, {u0, v1}});
+    for (int i : {0, 1, 2, 0, 2, 3}) {
+        _indices.push_back(base + i);
+    }
+}
+
+void SpriteBatch::flush()
+{
+    if (!_indices.empty()) {
+        renderCheck(SDL_RenderGeometry(
+            _renderer,
+            _texture,
+            _vertices.data(),
+            static_cast<int>(_vertices.size()),
+            _indices.data(),
+            static_cast<int>(_indices.size())));
+    }
+    _vertices.clear();
+    _indices.clear();
+    _texture = nullptr;
+}
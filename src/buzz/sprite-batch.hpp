@@ -0,0 +1,28 @@
+#pragma once
+
+#include "sdl.hpp"
+
+#include <vector>
+
+// Collects textured quads and submits each run of quads sharing a texture
+// with a single SDL_RenderGeometry call. Quads are drawn in the order they
+// were added. With batching disabled, every quad is drawn right away with
+// SDL_RenderCopyF.
+class SpriteBatch {
+public:
+    explicit SpriteBatch(SDL_Renderer* renderer = nullptr, bool enabled = true);
+
+    void draw(
+        SDL_Texture* texture, const SDL_Rect* source, const SDL_FRect& target);
+    void flush();
+
+private:
+    SDL_Renderer* _renderer = nullptr;
+    bool _enabled = true;
+
+    SDL_Texture* _texture = nullptr;
+    float _textureWidth = 0.f;
+    float _textureHeight = 0.f;
+    std::vector<SDL_Vertex> _vertices;
+    std::vector<int> _indices;
+};
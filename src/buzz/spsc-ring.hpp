@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+
+// Lock-free single-producer single-consumer ring of fixed capacity. Each side
+// keeps a cached copy of the other side's index and reloads it only when the
+// ring looks full or empty, so the shared cache lines change hands once per
+// batch rather than once per item.
+template <class T, size_t Capacity>
+class SpscRing {
+    static_assert(std::has_single_bit(Capacity));
+
+public:
+    // Producer side. Returns false if the ring is full.
+    bool push(const T& value)
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        if (head - _tailCache == Capacity) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+            if (head - _tailCache == Capacity) {
+                return false;
+            }
+        }
+        _items[head % Capacity] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. The oldest item, or nullptr if the ring is empty.
+    const T* front()
+    {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _headCache) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (tail == _headCache) {
+                return nullptr;
+            }
+        }
+        return &_items[tail % Capacity];
+    }
+
+    // Consumer side. Drops the item returned by front().
+    void pop()
+    {
+        _tail.store(
+            _tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> _head {0};
+    size_t _tailCache = 0;
+
+    alignas(64) std::atomic<size_t> _tail {0};
+    size_t _headCache = 0;
+
+    alignas(64) std::array<T, Capacity> _items {};
+};
@@ -0,0 +1,42 @@
+#include "startup.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const auto processStart = Clock::now();
+auto phases = std::vector<std::pair<std::string, Clock::time_point>>{};
+
+double milliseconds(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>{duration}.count();
+}
+
+} // namespace
+
+void startupPhase(std::string name)
+{
+    phases.emplace_back(std::move(name), Clock::now());
+}
+
+void reportStartup(std::ostream& output)
+{
+    const auto flags = output.flags();
+    const auto precision = output.precision();
+    output << "startup, ms:\n" << std::fixed << std::setprecision(1);
+    auto previous = processStart;
+    for (const auto& [name, time] : phases) {
+        output << "  " << std::setw(8) << milliseconds(time - previous) <<
+            "  " << name << "\n";
+        previous = time;
+    }
+    output << "  " << std::setw(8) << milliseconds(previous - processStart) <<
+        "  total\n";
+    output.flags(flags);
+    output.precision(precision);
+}
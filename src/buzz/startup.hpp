@@ -0,0 +1,9 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+// Timeline of startup, measured from process start. Each call marks the end
+// of a phase; the report lists phase durations and the total.
+void startupPhase(std::string name);
+void reportStartup(std::ostream& output);
@@ -0,0 +1,129 @@
+#include "static-grid.hpp"
+
+#include "error.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Sparse layouts get coarser cells rather than mostly empty cell arrays
+constexpr size_t MinCells = 1024;
+constexpr size_t CellsPerBody = 4;
+
+} // namespace
+
+StaticGrid::StaticGrid(std::vector<Body> bodies, float cellSize)
+    : _cellSize(cellSize)
+{
+    check(cellSize > 0);
+    if (bodies.empty()) {
+        return;
+    }
+
+    std::sort(bodies.begin(), bodies.end(), [] (const auto& a, const auto& b) {
+        return a.order < b.order;
+    });
+
+    constexpr float Infinity = std::numeric_limits<float>::infinity();
+    auto min = XYVector{Infinity, Infinity};
+    auto max = XYVector{-Infinity, -Infinity};
+    for (const auto& body : bodies) {
+        min.x = std::min(min.x, body.position.x - body.radius);
+        min.y = std::min(min.y, body.position.y - body.radius);
+        max.x = std::max(max.x, body.position.x + body.radius);
+        max.y = std::max(max.y, body.position.y + body.radius);
+    }
+
+    const size_t maxCells = std::max(MinCells, bodies.size() * CellsPerBody);
+    auto cellCount = [this, &min, &max] {
+        _columns = static_cast<int>(std::floor((max.x - min.x) / _cellSize)) + 1;
+        _rows = static_cast<int>(std::floor((max.y - min.y) / _cellSize)) + 1;
+        return static_cast<size_t>(_columns) * _rows;
+    };
+    while (cellCount() > maxCells) {
+        _cellSize *= 2;
+    }
+    _origin = min;
+
+    // Counting sort of bodies into cells. Bodies go in by index, so every
+    // cell lists them in ascending order.
+    _cellStarts.assign(static_cast<size_t>(_columns) * _rows + 1, 0);
+    auto ranges = std::vector<CellRange>{};
+    ranges.reserve(bodies.size());
+    for (const auto& body : bodies) {
+        auto extent = XYVector{body.radius, body.radius};
+        const auto& range = ranges.emplace_back(
+            cellRange(body.position - extent, body.position + extent));
+        for (int y = range.minY; y <= range.maxY; y++) {
+            for (int x = range.minX; x <= range.maxX; x++) {
+                _cellStarts[static_cast<size_t>(y) * _columns + x + 1]++;
+            }
+        }
+    }
+    for (size_t i = 1; i < _cellStarts.size(); i++) {
+        _cellStarts[i] += _cellStarts[i - 1];
+    }
+
+    _cellBodies.resize(_cellStarts.back());
+    auto next = std::vector<uint32_t>(_cellStarts.begin(), _cellStarts.end() - 1);
+    for (uint32_t i = 0; i < ranges.size(); i++) {
+        const auto& range = ranges[i];
+        for (int y = range.minY; y <= range.maxY; y++) {
+            for (int x = range.minX; x <= range.maxX; x++) {
+                _cellBodies[next[static_cast<size_t>(y) * _columns + x]++] = i;
+            }
+        }
+    }
+
+    _shapes.reserve(bodies.size());
+    _orders.reserve(bodies.size());
+    _entities.reserve(bodies.size());
+    for (const auto& body : bodies) {
+        _shapes.push_back({body.position.x, body.position.y, body.radius});
+        _orders.push_back(body.order);
+        _entities.push_back(body.entity);
+    }
+}
+
+void StaticGrid::query(
+    const XYVector& min,
+    const XYVector& max,
+    std::vector<uint32_t>& result) const
+{
+    result.clear();
+
+    auto cells = cellRange(min, max);
+    for (int y = cells.minY; y <= cells.maxY; y++) {
+        const auto row = static_cast<size_t>(y) * _columns;
+        for (int x = cells.minX; x <= cells.maxX; x++) {
+            result.insert(
+                result.end(),
+                _cellBodies.begin() + _cellStarts[row + x],
+                _cellBodies.begin() + _cellStarts[row + x + 1]);
+        }
+    }
+
+    // Bodies spanning several cells have been collected more than once
+    if (cells.minX != cells.maxX || cells.minY != cells.maxY) {
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+}
+
+StaticGrid::CellRange StaticGrid::cellRange(
+    const XYVector& min, const XYVector& max) const
+{
+    auto cell = [this] (float coordinate, float origin, int count) {
+        auto i = std::floor((coordinate - origin) / _cellSize);
+        return static_cast<int>(std::clamp(i, -1.f, static_cast<float>(count)));
+    };
+
+    return {
+        .minX = std::max(cell(min.x, _origin.x, _columns), 0),
+        .minY = std::max(cell(min.y, _origin.y, _rows), 0),
+        .maxX = std::min(cell(max.x, _origin.x, _columns), _columns - 1),
+        .maxY = std::min(cell(max.y, _origin.y, _rows), _rows - 1),
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "types.hpp"
+
+#include "thing.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Immutable uniform grid over circles that never move, built in one go. Cells
+// cover the bounds of the bodies densely, and the body indices of all cells
+// are packed into one array, so a query is a few short contiguous scans.
+// Bodies are stored sorted by order, which makes index order the same as body
+// order.
+class StaticGrid {
+public:
+    struct Body {
+        thing::Entity entity;
+        uint64_t order = 0;
+        XYVector position;
+        float radius = 0.f;
+    };
+
+    StaticGrid() = default;
+    StaticGrid(std::vector<Body> bodies, float cellSize);
+
+    // Collects indices of bodies with bounding boxes overlapping the
+    // [min, max] box, in ascending order. Safe to call from several threads.
+    void query(
+        const XYVector& min,
+        const XYVector& max,
+        std::vector<uint32_t>& result) const;
+
+    size_t size() const { return _shapes.size(); }
+
+    thing::Entity entity(uint32_t index) const { return _entities[index]; }
+    uint64_t order(uint32_t index) const { return _orders[index]; }
+    XYVector position(uint32_t index) const
+    {
+        return {_shapes[index].x, _shapes[index].y};
+    }
+    float radius(uint32_t index) const { return _shapes[index].radius; }
+
+private:
+    struct Shape {
+        float x = 0.f;
+        float y = 0.f;
+        float radius = 0.f;
+    };
+
+    struct CellRange {
+        int minX = 0;
+        int minY = 0;
+        int maxX = -1;
+        int maxY = -1;
+    };
+
+    CellRange cellRange(const XYVector& min, const XYVector& max) const;
+
+    float _cellSize = 1.f;
+    XYVector _origin;
+    int _columns = 0;
+    int _rows = 0;
+    std::vector<uint32_t> _cellStarts;
+    std::vector<uint32_t> _cellBodies;
+
+    std::vector<Shape> _shapes;
+    std::vector<uint64_t> _orders;
+    std::vector<thing::Entity> _entities;
+};
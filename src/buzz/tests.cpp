@@ -0,0 +1,209 @@
+#include "animation.hpp"
+#include "camera.hpp"
+#include "error.hpp"
+#include "level.hpp"
+#include "sdl.hpp"
+#include "sprite-batch.hpp"
+#include "tilemap.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr int TileSize = 8;
+constexpr int PixelsInUnit = 8;
+constexpr float ChunkUnits = 1.f * Tilemap::ChunkSize * TileSize / PixelsInUnit;
+constexpr auto TilesetRect =
+    SDL_Rect{.x = 0, .y = 0, .w = 4 * TileSize, .h = TileSize};
+
+// Software renderer drawing into a surface, so no window or video driver is
+// needed
+class OffscreenRenderer {
+public:
+    OffscreenRenderer()
+        : _surface(
+            sdlCheck(SDL_CreateRGBSurfaceWithFormat(
+                0, 320, 240, 32, SDL_PIXELFORMAT_RGBA32)),
+            SDL_FreeSurface)
+        , _renderer(
+            sdlCheck(SDL_CreateSoftwareRenderer(_surface.get())),
+            SDL_DestroyRenderer)
+    { }
+
+    SDL_Renderer* raw() const { return _renderer.get(); }
+
+    // Blank tileset, four tiles wide
+    std::unique_ptr<SDL_Texture, void(*)(SDL_Texture*)> tileset() const
+    {
+        return {
+            sdlCheck(SDL_CreateTexture(
+                _renderer.get(),
+                SDL_PIXELFORMAT_RGBA32,
+                SDL_TEXTUREACCESS_STATIC,
+                TilesetRect.w,
+                TilesetRect.h)),
+            SDL_DestroyTexture};
+    }
+
+private:
+    std::unique_ptr<SDL_Surface, void(*)(SDL_Surface*)> _surface;
+    std::unique_ptr<SDL_Renderer, void(*)(SDL_Renderer*)> _renderer;
+};
+
+// Shows 3 by 2 chunks around the chunk column it is centered on
+Camera chunkCamera(int chunkX)
+{
+    return Camera{
+        .pixelsPerUnit = PixelsInUnit,
+        .scale = 1,
+        .screenSize = {320, 240},
+        .center = {(chunkX + 0.5f) * ChunkUnits, 0.f},
+    };
+}
+
+// The message LevelFile fails with for the file, or nothing if it loads
+std::string levelError(const std::filesystem::path& path)
+{
+    try {
+        auto level = LevelFile{path};
+    } catch (const Error& error) {
+        return error.what();
+    }
+    return {};
+}
+
+} // namespace
+
+TEST_CASE("Tilemap renders chunks only when they change", "[tilemap]")
+{
+    auto renderer = OffscreenRenderer{};
+    auto tileset = renderer.tileset();
+    auto tilemap = Tilemap{
+        renderer.raw(), tileset.get(), TilesetRect, TileSize, PixelsInUnit};
+    auto batch = SpriteBatch{renderer.raw()};
+    const auto camera = chunkCamera(0);
+
+    // Chunks without tiles all share one default chunk
+    tilemap.draw(camera, batch);
+    tilemap.draw(camera, batch);
+    CHECK(tilemap.storedChunks() == 0);
+    CHECK(tilemap.cachedTextures() == 0);
+    CHECK(tilemap.renderedChunks() == 1);
+
+    // One tile in each of three visible chunks
+    tilemap.setTile(0, 0, 1);
+    tilemap.setTile(-1, -1, 2);
+    tilemap.setTile(Tilemap::ChunkSize + 3, 5, 3);
+    CHECK(tilemap.storedChunks() == 3);
+    CHECK(tilemap.tile(-1, -1) == 2);
+    CHECK(tilemap.tile(100, 100) == 0);
+
+    tilemap.draw(camera, batch);
+    CHECK(tilemap.cachedTextures() == 3);
+    CHECK(tilemap.renderedChunks() == 4);
+
+    // Setting a tile to the same value does not render the chunk again
+    tilemap.setTile(0, 0, 1);
+    tilemap.draw(camera, batch);
+    CHECK(tilemap.renderedChunks() == 4);
+
+    // Only the chunk that changed is rendered again
+    tilemap.setTile(1, 0, 2);
+    tilemap.draw(camera, batch);
+    CHECK(tilemap.renderedChunks() == 5);
+    CHECK(tilemap.storedChunks() == 3);
+}
+
+TEST_CASE("Tilemap evicts textures of chunks out of view", "[tilemap]")
+{
+    auto renderer = OffscreenRenderer{};
+    auto tileset = renderer.tileset();
+    auto tilemap = Tilemap{
+        renderer.raw(), tileset.get(), TilesetRect, TileSize, PixelsInUnit, 1};
+    auto batch = SpriteBatch{renderer.raw()};
+
+    constexpr int Chunks = 2 * Tilemap::MaxCachedTextures;
+    for (int x = 0; x < Chunks; x++) {
+        tilemap.setTile(x * Tilemap::ChunkSize, 0, 0);
+    }
+    CHECK(tilemap.storedChunks() == Chunks);
+
+    for (int x = 0; x < Chunks; x++) {
+        tilemap.draw(chunkCamera(x), batch);
+        CHECK(tilemap.cachedTextures() <= Tilemap::MaxCachedTextures);
+    }
+    CHECK(tilemap.storedChunks() == Chunks);
+
+    // Back at the start, the evicted chunks have to be rendered again
+    const auto rendered = tilemap.renderedChunks();
+    tilemap.draw(chunkCamera(0), batch);
+    CHECK(tilemap.renderedChunks() > rendered);
+}
+
+TEST_CASE("Error::what follows the message as it grows", "[error]")
+{
+    auto error = Error{} << "first";
+    CHECK(std::string{error.what()}.ends_with(": first"));
+
+    error << ", second";
+    CHECK(std::string{error.what()}.ends_with(": first, second"));
+
+    // Copies format their own text
+    auto copy = error;
+    copy << ", third";
+    CHECK(std::string{copy.what()}.ends_with(": first, second, third"));
+    CHECK(std::string{error.what()}.ends_with(": first, second"));
+}
+
+TEST_CASE("AnimationLibrary rejects bad clips", "[animation]")
+{
+    const auto sheet = SDL_Rect{.x = 0, .y = 0, .w = 16, .h = 16};
+    CHECK_THROWS_AS(AnimationClip::strip(nullptr, sheet, 8, 8, 0), Error);
+
+    auto library = AnimationLibrary{};
+    const auto& tree = library.add(
+        "tree", AnimationClip::strip(nullptr, sheet, 8, 8, 2));
+    CHECK_THROWS_AS(
+        library.add("tree", AnimationClip::strip(nullptr, sheet, 8, 8, 1)),
+        Error);
+    CHECK(&library.clip("tree") == &tree);
+    CHECK(tree.frameCount() == 2);
+}
+
+TEST_CASE("LevelFile names the file it rejects", "[level]")
+{
+    namespace fs = std::filesystem;
+    const auto directory = fs::temp_directory_path() / "buzz-test";
+    fs::create_directories(directory);
+
+    auto level = LevelData{};
+    level.objects.push_back(LevelObject{
+        .radius = 1.f,
+        .type = level.typeIndex(ObjectType::Hero),
+    });
+    level.movements.push_back(LevelMovement{.object = 0});
+    const auto good = directory / "good.level";
+    writeLevel(good, level);
+    CHECK(levelError(good).empty());
+
+    const auto empty = directory / "empty.level";
+    std::ofstream{empty};
+    CHECK(levelError(empty).ends_with(empty.string() + " is empty"));
+
+    const auto truncated = directory / "truncated.level";
+    fs::copy_file(good, truncated, fs::copy_options::overwrite_existing);
+    fs::resize_file(truncated, fs::file_size(good) - 1);
+    CHECK(levelError(truncated).ends_with(
+        truncated.string() + " is truncated or corrupt"));
+
+    level.movements.push_back(LevelMovement{.object = 0});
+    const auto duplicate = directory / "duplicate.level";
+    writeLevel(duplicate, level);
+    CHECK(levelError(duplicate).ends_with(
+        duplicate.string() + " has more than one movement for object 0"));
+}
@@ -0,0 +1,31 @@
+#include "texture.hpp"
+
+Texture::Texture(
+        SDL_Renderer* renderer, const std::filesystem::path& pathToImageFile)
+    : Texture(sdlCheck(IMG_LoadTexture(renderer, pathToImageFile.c_str())))
+{ }
+
+Texture::Texture(SDL_Renderer* renderer, ImageFuture&& image)
+    : Texture(sdlCheck(SDL_CreateTextureFromSurface(renderer, image.get().get())))
+{ }
+
+Texture::Texture(SDL_Texture* sdlTexture)
+{
+    _sdlTexture.reset(sdlTexture);
+    sdlCheck(SDL_QueryTexture(_sdlTexture.get(), nullptr, nullptr, &_width, &_height));
+}
+
+SDL_Texture* Texture::raw() const
+{
+    return _sdlTexture.get();
+}
+
+const int Texture::width() const
+{
+    return _width;
+}
+
+const int Texture::height() const
+{
+    return _height;
+}
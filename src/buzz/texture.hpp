@@ -0,0 +1,26 @@
+#pragma once
+
+#include "asset-loader.hpp"
+#include "sdl.hpp"
+
+#include <filesystem>
+#include <memory>
+
+class Texture final {
+public:
+    Texture() {}
+    Texture(SDL_Renderer* renderer, const std::filesystem::path& pathToImageFile);
+    explicit Texture(SDL_Texture* sdlTexture);
+
+    // Waits for a background decode to finish, then uploads the image
+    Texture(SDL_Renderer* renderer, ImageFuture&& image);
+
+    SDL_Texture* raw() const;
+    const int width() const;
+    const int height() const;
+
+private:
+    std::unique_ptr<SDL_Texture, void(*)(SDL_Texture*)> _sdlTexture {nullptr, SDL_DestroyTexture};
+    int _width = 0;
+    int _height = 0;
+};
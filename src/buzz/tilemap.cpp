@@ -0,0 +1,181 @@
+#include "tilemap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+int floorDiv(int a, int b)
+{
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+} // namespace
+
+Tilemap::Tilemap(
+        SDL_Renderer* renderer,
+        SDL_Texture* tileset,
+        const SDL_Rect& tilesetRect,
+        int tileSize,
+        int pixelsPerUnit,
+        int defaultTile)
+    : _renderer(renderer)
+    , _tileset(tileset)
+    , _tilesetOrigin{tilesetRect.x, tilesetRect.y}
+    , _tileSize(tileSize)
+    , _pixelsPerUnit(pixelsPerUnit)
+    , _defaultTile(static_cast<uint16_t>(defaultTile))
+{
+    check(tileSize > 0 && pixelsPerUnit > 0);
+    _tilesetColumns = std::max(tilesetRect.w / tileSize, 1);
+    _defaultChunk.tiles.fill(_defaultTile);
+}
+
+int Tilemap::tile(int x, int y) const
+{
+    auto it = _chunks.find(
+        chunkKey(floorDiv(x, ChunkSize), floorDiv(y, ChunkSize)));
+    if (it == _chunks.end()) {
+        return _defaultTile;
+    }
+    int localX = x - floorDiv(x, ChunkSize) * ChunkSize;
+    int localY = y - floorDiv(y, ChunkSize) * ChunkSize;
+    return it->second.tiles[localY * ChunkSize + localX];
+}
+
+void Tilemap::setTile(int x, int y, int tile)
+{
+    auto& c = chunk(floorDiv(x, ChunkSize), floorDiv(y, ChunkSize));
+    int localX = x - floorDiv(x, ChunkSize) * ChunkSize;
+    int localY = y - floorDiv(y, ChunkSize) * ChunkSize;
+    auto& t = c.tiles[localY * ChunkSize + localX];
+    if (t != tile) {
+        t = static_cast<uint16_t>(tile);
+        c.dirty = true;
+    }
+}
+
+void Tilemap::invalidate()
+{
+    for (auto& [key, c] : _chunks) {
+        c.texture.reset();
+        c.dirty = true;
+    }
+    _defaultChunk.texture.reset();
+    _defaultChunk.dirty = true;
+    _cachedTextures = 0;
+}
+
+void Tilemap::draw(const Camera& camera, SpriteBatch& batch)
+{
+    _frame++;
+
+    const int chunkPixels = ChunkSize * _tileSize;
+    const float chunkUnits = 1.f * chunkPixels / _pixelsPerUnit;
+    const auto min = camera.center - camera.halfView();
+    const auto max = camera.center + camera.halfView();
+    const int minX = static_cast<int>(std::floor(min.x / chunkUnits));
+    const int minY = static_cast<int>(std::floor(min.y / chunkUnits));
+    const int maxX = static_cast<int>(std::floor(max.x / chunkUnits));
+    const int maxY = static_cast<int>(std::floor(max.y / chunkUnits));
+
+    for (int y = maxY; y >= minY; y--) {
+        for (int x = minX; x <= maxX; x++) {
+            // Chunks exist only where tiles were set; all others share the
+            // default chunk
+            auto it = _chunks.find(chunkKey(x, y));
+            auto& c = it != _chunks.end() ? it->second : _defaultChunk;
+            if (c.dirty || !c.texture) {
+                // Chunk rendering switches render targets, so anything queued
+                // for the current target has to go out first
+                batch.flush();
+                render(c);
+            }
+            c.lastDrawn = _frame;
+
+            auto center = XYVector{(x + 0.5f) * chunkUnits, (y + 0.5f) * chunkUnits};
+            batch.draw(
+                c.texture.get(),
+                nullptr,
+                camera.rect(center, chunkPixels, chunkPixels));
+        }
+    }
+
+    evictTextures();
+}
+
+Tilemap::Chunk& Tilemap::chunk(int chunkX, int chunkY)
+{
+    auto [it, inserted] = _chunks.try_emplace(chunkKey(chunkX, chunkY));
+    if (inserted) {
+        it->second.tiles.fill(_defaultTile);
+    }
+    return it->second;
+}
+
+void Tilemap::render(Chunk& chunk)
+{
+    const int chunkPixels = ChunkSize * _tileSize;
+    if (!chunk.texture) {
+        chunk.texture.reset(sdlCheck(SDL_CreateTexture(
+            _renderer,
+            SDL_PIXELFORMAT_RGBA32,
+            SDL_TEXTUREACCESS_TARGET,
+            chunkPixels,
+            chunkPixels)));
+        sdlCheck(SDL_SetTextureBlendMode(
+            chunk.texture.get(), SDL_BLENDMODE_BLEND));
+        if (&chunk != &_defaultChunk) {
+            _cachedTextures++;
+        }
+    }
+
+    auto previousTarget = SDL_GetRenderTarget(_renderer);
+    sdlCheck(SDL_SetRenderTarget(_renderer, chunk.texture.get()));
+    sdlCheck(SDL_SetRenderDrawColor(_renderer, 0, 0, 0, 0));
+    sdlCheck(SDL_RenderClear(_renderer));
+
+    for (int y = 0; y < ChunkSize; y++) {
+        for (int x = 0; x < ChunkSize; x++) {
+            int tile = chunk.tiles[y * ChunkSize + x];
+            auto source = SDL_Rect{
+                .x = _tilesetOrigin.x + tile % _tilesetColumns * _tileSize,
+                .y = _tilesetOrigin.y + tile / _tilesetColumns * _tileSize,
+                .w = _tileSize,
+                .h = _tileSize,
+            };
+            auto target = SDL_Rect{
+                .x = x * _tileSize,
+                .y = (ChunkSize - 1 - y) * _tileSize,
+                .w = _tileSize,
+                .h = _tileSize,
+            };
+            renderCheck(SDL_RenderCopy(_renderer, _tileset, &source, &target));
+        }
+    }
+
+    sdlCheck(SDL_SetRenderTarget(_renderer, previousTarget));
+    chunk.dirty = false;
+    _renderedChunks++;
+}
+
+void Tilemap::evictTextures()
+{
+    if (_cachedTextures <= MaxCachedTextures) {
+        return;
+    }
+
+    for (auto& [key, c] : _chunks) {
+        if (c.texture && c.lastDrawn != _frame) {
+            c.texture.reset();
+            c.dirty = true;
+            _cachedTextures--;
+        }
+    }
+}
+
+uint64_t Tilemap::chunkKey(int chunkX, int chunkY)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) |
+        static_cast<uint32_t>(chunkY);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "camera.hpp"
+#include "sdl.hpp"
+#include "sprite-batch.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+// Tile layer of unbounded size, split into square chunks. Each chunk is
+// pre-rendered into a target texture the first time it is visible, and is
+// rendered again only after one of its tiles changes. Only chunks with a tile
+// set are stored; all others are drawn from one shared default-tile chunk.
+class Tilemap {
+public:
+    static constexpr int ChunkSize = 16;
+    static constexpr size_t MaxCachedTextures = 64;
+
+    Tilemap() {}
+    Tilemap(
+        SDL_Renderer* renderer,
+        SDL_Texture* tileset,
+        const SDL_Rect& tilesetRect,
+        int tileSize,
+        int pixelsPerUnit,
+        int defaultTile = 0);
+
+    int tile(int x, int y) const;
+    void setTile(int x, int y, int tile);
+
+    // Drop all chunk textures, e.g. after SDL_RENDER_TARGETS_RESET
+    void invalidate();
+
+    void draw(const Camera& camera, SpriteBatch& batch);
+
+    size_t storedChunks() const { return _chunks.size(); }
+    size_t cachedTextures() const { return _cachedTextures; }
+    uint64_t renderedChunks() const { return _renderedChunks; }
+
+private:
+    using TextureHandle =
+        std::unique_ptr<SDL_Texture, void(*)(SDL_Texture*)>;
+
+    struct Chunk {
+        std::array<uint16_t, ChunkSize * ChunkSize> tiles {};
+        TextureHandle texture {nullptr, SDL_DestroyTexture};
+        bool dirty = true;
+        uint64_t lastDrawn = 0;
+    };
+
+    Chunk& chunk(int chunkX, int chunkY);
+    void render(Chunk& chunk);
+    void evictTextures();
+
+    static uint64_t chunkKey(int chunkX, int chunkY);
+
+    SDL_Renderer* _renderer = nullptr;
+    SDL_Texture* _tileset = nullptr;
+    SDL_Point _tilesetOrigin {};
+    int _tileSize = 0;
+    int _tilesetColumns = 1;
+    int _pixelsPerUnit = 1;
+    uint16_t _defaultTile = 0;
+
+    std::unordered_map<uint64_t, Chunk> _chunks;
+    Chunk _defaultChunk;
+    size_t _cachedTextures = 0;
+    uint64_t _renderedChunks = 0;
+    uint64_t _frame = 0;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// Lock-free single-producer single-consumer triple buffer. The writer fills
+// back() and publishes it; the reader acquires the most recently published
+// value into front(). Neither side ever waits for the other.
+template <class T>
+class TripleBuffer {
+public:
+    T& back()
+    {
+        return _buffers[_back];
+    }
+
+    void publish()
+    {
+        _back = _middle.exchange(_back | Fresh, std::memory_order_acq_rel) &
+            IndexMask;
+    }
+
+    // Returns true if a newer value has been published since the last call
+    bool acquire()
+    {
+        if (!(_middle.load(std::memory_order_relaxed) & Fresh)) {
+            return false;
+        }
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) &
+            IndexMask;
+        return true;
+    }
+
+    const T& front() const
+    {
+        return _buffers[_front];
+    }
+
+private:
+    static constexpr unsigned Fresh = 4;
+    static constexpr unsigned IndexMask = 3;
+
+    std::array<T, 3> _buffers;
+    unsigned _back = 0;
+    std::atomic<unsigned> _middle {1};
+    unsigned _front = 2;
+};
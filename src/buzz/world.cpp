@@ -1,126 +1,877 @@
 #include "world.hpp"
 
+#include "arena.hpp"
 #include "events.hpp"
+#include "input-log.hpp"
+#include "profiler.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <iostream>
+#include <map>
+#include <numbers>
+#include <utility>
+
+namespace {
+
+constexpr float BroadphaseCellSize = 2.f;
+constexpr size_t MoversPerJob = 256;
+
+} // namespace
 
 World::World(evening::Channel& worldEvents, evening::Channel& controlEvents)
     : _worldEvents(worldEvents)
+    , _broadphase(BroadphaseCellSize)
 {
     subscribe<XYVector>(controlEvents, [this] (const auto& control) {
-        if (_control) {
-            _control->control = control;
-            if (length(_control->control) > 1) {
-                _control->control = unit(_control->control);
-            }
+        if (_recorder) {
+            _recorder->control(_tick, control);
         }
+        auto normalized = length(control) > 1 ? unit(control) : control;
+        for (auto e : _controlled) {
+            _movers[_moverSlots.at(e)].control = normalized;
+        }
+    });
+
+    subscribe<InputStamp>(controlEvents, [this] (const auto& stamp) {
+        _pendingInputs.push_back(stamp.timestamp);
     });
 }
 
-void World::initTestLevel()
+void World::streamRegions(const RegionStreaming& streaming)
 {
-    {
-        auto hero = _ecs.createEntity();
-        const auto& location = _ecs.add(hero, WorldLocation{
-            .position = {0, 0},
+    _streaming = streaming;
+}
+
+void World::loadLevel(const LevelView& level)
+{
+    loadObjects(level.types(), level.objects(), level.movements());
+}
+
+void World::initStressLevel(const StressLevel& level)
+{
+    _random.seed(level.seed);
+
+    const float side =
+        std::sqrt(std::max(level.obstacles, 1) / level.obstacleDensity);
+    auto coordinate = std::uniform_real_distribution<float>{-side / 2, side / 2};
+
+    auto generated = LevelData{};
+    const auto treeType = generated.typeIndex(ObjectType::Tree);
+    const auto heroType = generated.typeIndex(ObjectType::Hero);
+    generated.objects.reserve(level.obstacles + level.movers);
+    generated.movements.reserve(level.movers);
+    for (int i = 0; i < level.obstacles; i++) {
+        generated.objects.push_back(LevelObject{
+            .x = coordinate(_random),
+            .y = coordinate(_random),
             .radius = 1.f,
+            .type = treeType,
         });
-        _ecs.add(hero, WorldMovement{
-            .velocity = {0, 0},
+    }
+
+    for (int i = 0; i < level.movers; i++) {
+        generated.movements.push_back(LevelMovement{
+            .object = static_cast<uint32_t>(generated.objects.size()),
+            .flags = level.randomMovers ?
+                LevelMovementFlags::Wandering : LevelMovementFlags::Controlled,
             .maxSpeed = 8.f,
             .accelerationTime = 0.2f,
             .decelerationTime = 0.2f,
         });
-        _control = &_ecs.add(hero, Control{});
-        _worldEvents.push(Spawn{
-            .entity = hero,
-            .objectType = ObjectType::Hero,
-            .location = location.position,
+        generated.objects.push_back(LevelObject{
+            .x = coordinate(_random),
+            .y = coordinate(_random),
+            .radius = 1.f,
+            .type = heroType,
         });
     }
 
-    {
-        auto tree1 = _ecs.createEntity();
-        const auto& location = _ecs.add(tree1, WorldLocation{
-            .position = {1.f, -1.f},
-            .radius = 1,
-        });
-        _worldEvents.push(Spawn{
-            .entity = tree1,
-            .objectType = ObjectType::Tree,
+    loadObjects(generated.types, generated.objects, generated.movements);
+}
+
+void World::loadObjects(
+    std::span<const LevelObjectType> types,
+    std::span<const LevelObject> objects,
+    std::span<const LevelMovement> movements)
+{
+    auto focus = std::optional<uint32_t>{};
+    for (const auto& movement : movements) {
+        if (movement.flags & LevelMovementFlags::Controlled) {
+            focus = movement.object;
+            break;
+        }
+    }
+    if (!focus && !movements.empty()) {
+        focus = movements.front().object;
+    }
+
+    if (_streaming.regionSize <= 0) {
+        auto entities = spawnObjects(types, objects, movements);
+        if (focus) {
+            _focusEntity = entities[*focus];
+            _worldEvents.push(Focus{*_focusEntity});
+        }
+        bakeStatics();
+        return;
+    }
+
+    if (focus) {
+        const auto& object = objects[*focus];
+        _focusRegion = region({object.x, object.y});
+    }
+
+    // Split the level by region. Only the regions around the focus are
+    // spawned, the rest go straight to the store.
+    auto objectTypes = std::vector<ObjectType>{};
+    for (const auto& type : types) {
+        objectTypes.push_back(objectType(typeName(type)));
+    }
+
+    auto regions = std::map<RegionCoord, LevelData>{};
+    auto objectRegions = std::vector<RegionCoord>{};
+    auto objectIndices = std::vector<uint32_t>{};
+    objectRegions.reserve(objects.size());
+    objectIndices.reserve(objects.size());
+    for (const auto& object : objects) {
+        const auto coord = region({object.x, object.y});
+        auto& data = regions[coord];
+        objectRegions.push_back(coord);
+        objectIndices.push_back(static_cast<uint32_t>(data.objects.size()));
+        auto& added = data.objects.emplace_back(object);
+        added.type = data.typeIndex(objectTypes[object.type]);
+    }
+    for (const auto& movement : movements) {
+        auto& added = regions[objectRegions[movement.object]].movements
+            .emplace_back(movement);
+        added.object = objectIndices[movement.object];
+    }
+
+    const int radius = _streaming.activeRadius;
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            _loadedRegions.insert({_focusRegion.x + x, _focusRegion.y + y});
+        }
+    }
+    for (auto& [coord, data] : regions) {
+        if (!_loadedRegions.contains(coord)) {
+            _regionStore.store(coord, std::move(data));
+            continue;
+        }
+
+        auto entities = spawnObjects(data.types, data.objects, data.movements);
+        if (focus && coord == objectRegions[*focus]) {
+            _focusEntity = entities[objectIndices[*focus]];
+        }
+    }
+    if (_focusEntity) {
+        _worldEvents.push(Focus{*_focusEntity});
+    }
+    bakeStatics();
+}
+
+std::vector<thing::Entity> World::spawnObjects(
+    std::span<const LevelObjectType> types,
+    std::span<const LevelObject> objects,
+    std::span<const LevelMovement> movements)
+{
+    auto objectTypes = std::vector<ObjectType>{};
+    for (const auto& type : types) {
+        objectTypes.push_back(objectType(typeName(type)));
+    }
+
+    auto objectMovements = std::vector<const LevelMovement*>(objects.size());
+    for (const auto& movement : movements) {
+        objectMovements[movement.object] = &movement;
+    }
+
+    // The whole batch is sized up front from the section counts
+    reserve(objects.size() - movements.size(), movements.size());
+    auto entities = std::vector<thing::Entity>{};
+    entities.reserve(objects.size());
+    auto batch = SpawnBatch{};
+    batch.spawns.reserve(objects.size());
+
+    // Bodies are ordered as the objects are, which is the order collisions
+    // are resolved in
+    for (size_t i = 0; i < objects.size(); i++) {
+        const auto& object = objects[i];
+        const auto entity = _ecs.createEntity();
+        const auto type = objectTypes[object.type];
+        const auto location = WorldLocation{
+            .position = {object.x, object.y},
+            .radius = object.radius,
+        };
+        if (const auto* movement = objectMovements[i]) {
+            addMover(entity, type, location, WorldMovement{
+                .velocity = {movement->velocityX, movement->velocityY},
+                .maxSpeed = movement->maxSpeed,
+                .accelerationTime = movement->accelerationTime,
+                .decelerationTime = movement->decelerationTime,
+            });
+            if (movement->flags & LevelMovementFlags::Controlled) {
+                _controlled.push_back(entity);
+            }
+            if (movement->flags & LevelMovementFlags::Wandering) {
+                _ecs.add(entity, Wander{});
+            }
+        } else {
+            addStatic(entity, type, location);
+        }
+        entities.push_back(entity);
+        batch.spawns.push_back(Spawn{
+            .entity = entity,
+            .objectType = type,
             .location = location.position,
         });
     }
+    _worldEvents.push(std::move(batch));
+    return entities;
+}
+
+void World::update(double delta)
+{
+    auto zone = ProfileZone{"World::update"};
 
+    _appliedInputs.insert(
+        _appliedInputs.end(), _pendingInputs.begin(), _pendingInputs.end());
+    _pendingInputs.clear();
+
+    auto& k = _kinematics;
     {
-        auto tree2 = _ecs.createEntity();
-        const auto& location = _ecs.add(tree2, WorldLocation{
-            .position = {2.f, 3.f},
-            .radius = 1,
-        });
-        _worldEvents.push(Spawn{
-            .entity = tree2,
-            .objectType = ObjectType::Tree,
-            .location = location.position,
+        auto pass = ProfileZone{"World::update/control"};
+
+        for (auto& e : _ecs.entities<Wander>()) {
+            auto& wander = _ecs.component<Wander>(e);
+            wander.timeLeft -= static_cast<float>(delta);
+            if (wander.timeLeft <= 0) {
+                auto angle = std::uniform_real_distribution<float>{
+                    0.f, 2 * std::numbers::pi_v<float>}(_random);
+                bool walk = std::bernoulli_distribution{0.8}(_random);
+                _movers[_moverSlots.at(e)].control = walk ?
+                    XYVector{std::cos(angle), std::sin(angle)} : XYVector{0, 0};
+                wander.timeLeft =
+                    std::uniform_real_distribution<float>{0.5f, 2.f}(_random);
+            }
+        }
+
+        for (size_t i = 0; i < k.size(); i++) {
+            const auto& mover = _movers[i];
+            const float acceleration = k.maxSpeed[i] / mover.accelerationTime;
+            auto velocity = XYVector{k.velocityX[i], k.velocityY[i]};
+            velocity += mover.control *
+                (acceleration + k.deceleration[i]) * delta;
+            k.velocityX[i] = velocity.x;
+            k.velocityY[i] = velocity.y;
+        }
+    }
+
+    {
+        auto pass = ProfileZone{"World::update/move"};
+
+        // Bodies at rest sleep: with no velocity left after the control
+        // pass, they have no control input either, so they stay where they
+        // are and only act as obstacles for others
+        _awake.clear();
+        for (uint32_t i = 0; i < k.size(); i++) {
+            auto& mover = _movers[i];
+            mover.awake =
+                k.velocityX[i] != 0 || k.velocityY[i] != 0 || mover.pushed;
+            mover.pushed = false;
+            if (mover.awake) {
+                _awake.push_back(Push{.slot = i});
+            }
+        }
+
+        // update moving object positions; sleeping bodies go through the
+        // kernel too, which leaves them where they are
+        const auto floatDelta = static_cast<float>(delta);
+        if (_jobs) {
+            _jobs->parallelFor(
+                k.size(),
+                MoversPerJob,
+                [this, floatDelta] (size_t begin, size_t end) {
+                    integrate(_kinematics, begin, end, floatDelta);
+                });
+        } else {
+            integrate(k, 0, k.size(), floatDelta);
+        }
+
+        for (const auto& awake : _awake) {
+            _broadphase.move(
+                _movers[awake.slot].proxy, moverPosition(awake.slot));
+            if (k.moved[awake.slot]) {
+                markMoved(awake.slot);
+            }
+        }
+
+        wakeTouched();
+    }
+
+    auto pass = ProfileZone{"World::update/collide"};
+    if (_jobs) {
+        // Every mover is pushed out of the state before the pass, and all
+        // results are applied afterwards, so the outcome does not depend on
+        // the number of threads or on scheduling
+        forEachAwake([this] (Push& push) {
+            thread_local CollisionScratch scratch;
+            const auto& mover = _movers[push.slot];
+            push.position = moverPosition(push.slot);
+            push.pushed = pushOut(
+                _broadphase.order(mover.proxy),
+                push.position,
+                mover.radius,
+                scratch);
         });
+        for (const auto& push : _awake) {
+            if (push.pushed) {
+                setMoverPosition(push.slot, push.position);
+                _broadphase.move(_movers[push.slot].proxy, push.position);
+                _movers[push.slot].pushed = true;
+                markMoved(push.slot);
+            }
+        }
+    } else {
+        // Each mover sees the objects resolved before it at their new places,
+        // as with a plain loop over all pairs
+        for (const auto& awake : _awake) {
+            auto& mover = _movers[awake.slot];
+            auto position = moverPosition(awake.slot);
+            if (pushOut(
+                    _broadphase.order(mover.proxy),
+                    position,
+                    mover.radius,
+                    _scratch)) {
+                setMoverPosition(awake.slot, position);
+                _broadphase.move(mover.proxy, position);
+                mover.pushed = true;
+                markMoved(awake.slot);
+            }
+        }
+    }
+
+    updateRegions();
+
+    _tick++;
+    if (_recorder) {
+        _recorder->checksum(_tick, checksum());
     }
 }
 
-void World::update(double delta)
+void World::setThreads(int threads)
+{
+    _jobs = threads > 1 ? std::make_unique<JobPool>(threads) : nullptr;
+}
+
+uint64_t World::checksum()
 {
-    auto acceleration = [] (const WorldMovement& m) {
-        return m.maxSpeed / m.accelerationTime;
+    // FNV-1a over the exact bits, so that any divergence shows
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash] (float value) {
+        hash = (hash ^ std::bit_cast<uint32_t>(value)) * 1099511628211ull;
     };
-    auto deceleration = [] (const WorldMovement& m) {
-        return m.maxSpeed / m.decelerationTime;
+    for (size_t i = 0; i < _kinematics.size(); i++) {
+        mix(_kinematics.positionX[i]);
+        mix(_kinematics.positionY[i]);
+        mix(_kinematics.velocityX[i]);
+        mix(_kinematics.velocityY[i]);
+    }
+    return hash;
+}
+
+void World::record(InputRecorder* recorder)
+{
+    _recorder = recorder;
+}
+
+LevelData World::exportLevel()
+{
+    // In body order, so that a level saved and loaded again resolves
+    // collisions the same way
+    auto bodies = std::vector<std::pair<uint64_t, thing::Entity>>{};
+    bodies.reserve(residentObjects());
+    const auto& statics = _staticBodies.entities();
+    size_t i = 0;
+    for (const auto& body : _staticBodies) {
+        bodies.emplace_back(body.order, statics[i++]);
+    }
+    for (const auto& mover : _movers) {
+        bodies.emplace_back(_broadphase.order(mover.proxy), mover.entity);
+    }
+    std::sort(
+        bodies.begin(), bodies.end(),
+        [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+    auto entities = std::vector<thing::Entity>{};
+    entities.reserve(bodies.size());
+    for (const auto& [order, e] : bodies) {
+        entities.push_back(e);
+    }
+    return exportEntities(entities, movementFlags());
+}
+
+EntityMap<uint32_t> World::movementFlags()
+{
+    auto flags = EntityMap<uint32_t>{};
+    flags.reserve(_movers.size());
+    for (const auto& mover : _movers) {
+        flags.insert(mover.entity, 0);
+    }
+    for (auto e : _controlled) {
+        flags.at(e) |= LevelMovementFlags::Controlled;
+    }
+    for (auto e : _ecs.entities<Wander>()) {
+        flags.at(e) |= LevelMovementFlags::Wandering;
+    }
+    return flags;
+}
+
+LevelData World::exportEntities(
+    std::span<const thing::Entity> entities,
+    const EntityMap<uint32_t>& flags)
+{
+    auto level = LevelData{};
+    level.objects.reserve(entities.size());
+    for (auto e : entities) {
+        const auto object = static_cast<uint32_t>(level.objects.size());
+        if (const auto* body = _staticBodies.find(e)) {
+            level.objects.push_back(LevelObject{
+                .x = body->location.position.x,
+                .y = body->location.position.y,
+                .radius = body->location.radius,
+                .type = level.typeIndex(body->type),
+            });
+            continue;
+        }
+
+        const auto slot = _moverSlots.at(e);
+        const auto& mover = _movers[slot];
+        const auto position = moverPosition(slot);
+        level.objects.push_back(LevelObject{
+            .x = position.x,
+            .y = position.y,
+            .radius = mover.radius,
+            .type = level.typeIndex(mover.type),
+        });
+        const auto* f = flags.find(e);
+        level.movements.push_back(LevelMovement{
+            .object = object,
+            .flags = f ? *f : 0,
+            .velocityX = _kinematics.velocityX[slot],
+            .velocityY = _kinematics.velocityY[slot],
+            .maxSpeed = _kinematics.maxSpeed[slot],
+            .accelerationTime = mover.accelerationTime,
+            .decelerationTime = mover.decelerationTime,
+        });
+    }
+    return level;
+}
+
+RegionCoord World::region(const XYVector& position) const
+{
+    return {
+        static_cast<int>(std::floor(position.x / _streaming.regionSize)),
+        static_cast<int>(std::floor(position.y / _streaming.regionSize)),
     };
+}
+
+RegionCoord World::gridRegion(const XYVector& position) const
+{
+    return _streaming.regionSize > 0 ? region(position) : RegionCoord{};
+}
+
+bool World::nearFocus(const RegionCoord& region, int radius) const
+{
+    return std::abs(region.x - _focusRegion.x) <= radius &&
+        std::abs(region.y - _focusRegion.y) <= radius;
+}
 
-    for (auto& e : _ecs.entities<Control>()) {
-        const auto& control = _ecs.component<Control>(e).control;
-        auto& movement = _ecs.component<WorldMovement>(e);
-        movement.velocity += control *
-            (acceleration(movement) + deceleration(movement)) * delta;
+void World::updateRegions()
+{
+    if (_streaming.regionSize <= 0) {
+        return;
+    }
+    auto zone = ProfileZone{"World::update/stream"};
+
+    // Movers that walked out of the resident regions are stored with the
+    // region they are in now
+    using Evicted = std::pair<const RegionCoord, FrameVector<thing::Entity>>;
+    auto evicted = std::map<
+        RegionCoord,
+        FrameVector<thing::Entity>,
+        std::less<>,
+        ArenaAllocator<Evicted>>{};
+    for (uint32_t i = 0; i < _movers.size(); i++) {
+        const auto entity = _movers[i].entity;
+        const auto coord = region(moverPosition(i));
+        if (!_loadedRegions.contains(coord) && entity != _focusEntity) {
+            evicted[coord].push_back(entity);
+        }
     }
 
-    // update moving object positions
-    for (auto& e : _ecs.entities<WorldMovement>()) {
-        auto& location = _ecs.component<WorldLocation>(e);
-        auto& movement = _ecs.component<WorldMovement>(e);
+    auto focusRegion = _focusRegion;
+    if (_focusEntity) {
+        focusRegion = region(moverPosition(_moverSlots.at(*_focusEntity)));
+    }
+    const bool focusMoved = focusRegion != _focusRegion;
+    _focusRegion = focusRegion;
+
+    if (focusMoved) {
+        std::erase_if(_loadedRegions, [this, &evicted] (const auto& coord) {
+            if (nearFocus(coord, _streaming.activeRadius + 1)) {
+                return false;
+            }
+
+            auto& entities = evicted[coord];
+            if (auto grid = _staticGrids.find(coord);
+                    grid != _staticGrids.end()) {
+                for (uint32_t i = 0; i < grid->second.size(); i++) {
+                    entities.push_back(grid->second.entity(i));
+                }
+                _staticGrids.erase(grid);
+            }
 
-        auto speed = length(movement.velocity);
-        if (speed > 0) {
-            auto targetSpeed = std::clamp(
-                static_cast<float>(speed - deceleration(movement) * delta),
-                0.f,
-                movement.maxSpeed);
-            movement.velocity *= targetSpeed / speed;
+            const auto size = _streaming.regionSize;
+            _broadphase.query(
+                {coord.x * size, coord.y * size},
+                {(coord.x + 1) * size, (coord.y + 1) * size},
+                _scratch.dynamics);
+            for (auto proxy : _scratch.dynamics) {
+                if (region(_broadphase.position(proxy)) == coord) {
+                    entities.push_back(_broadphase.entity(proxy));
+                }
+            }
+            return true;
+        });
+    }
+
+    if (!evicted.empty()) {
+        const auto flags = movementFlags();
+        for (auto& [coord, entities] : evicted) {
+            _regionStore.store(coord, exportEntities(entities, flags));
+            for (auto e : entities) {
+                despawn(e);
+            }
         }
+        auto despawned = [this] (thing::Entity e) {
+            return _moverSlots.find(e) == nullptr;
+        };
+        std::erase_if(_controlled, despawned);
+        std::erase_if(_moved, despawned);
+    }
+
+    if (focusMoved) {
+        const int radius = _streaming.activeRadius;
+        for (int y = -radius; y <= radius; y++) {
+            for (int x = -radius; x <= radius; x++) {
+                const auto coord =
+                    RegionCoord{_focusRegion.x + x, _focusRegion.y + y};
+                if (!_loadedRegions.insert(coord).second) {
+                    continue;
+                }
+                for (const auto& image : _regionStore.take(coord)) {
+                    auto level = LevelView{image.data(), image.size()};
+                    spawnObjects(level.types(), level.objects(), level.movements());
+                }
+            }
+        }
+        bakeStatics();
+    }
+}
+
+void World::publish()
+{
+    auto zone = ProfileZone{"World::publish"};
+
+    for (auto e : _moved) {
+        const auto slot = _moverSlots.at(e);
+        const auto location = moverPosition(slot);
+        const auto velocity =
+            XYVector{_kinematics.velocityX[slot], _kinematics.velocityY[slot]};
+        auto& published = _movers[slot].published;
+        published.dirty = false;
 
-        location.position += movement.velocity * delta;
+        if (location.x == published.location.x &&
+                location.y == published.location.y &&
+                velocity.x == published.velocity.x &&
+                velocity.y == published.velocity.y) {
+            continue;
+        }
 
+        published.location = location;
+        published.velocity = velocity;
         _worldEvents.push(Move{
             .entity = e,
+            .location = location,
+            .velocity = velocity});
+    }
+    _moved.clear();
+
+    for (auto timestamp : _appliedInputs) {
+        _worldEvents.push(InputApplied{timestamp});
+    }
+    _appliedInputs.clear();
+}
+
+void World::reserve(size_t statics, size_t movers)
+{
+    _staticBodies.reserve(_staticBodies.size() + statics);
+    _movers.reserve(_movers.size() + movers);
+    _moverSlots.reserve(_moverSlots.size() + movers);
+    _kinematics.reserve(_kinematics.size() + movers);
+    _broadphase.reserve(_broadphase.size() + movers);
+}
+
+void World::addStatic(
+    thing::Entity entity, ObjectType type, const WorldLocation& location)
+{
+    const auto order = _nextBodyOrder++;
+    _staticBodies.insert(entity, StaticBody{
+        .order = order,
+        .type = type,
+        .location = location,
+    });
+    _unbakedStatics[gridRegion(location.position)].push_back(StaticGrid::Body{
+        .entity = entity,
+        .order = order,
+        .position = location.position,
+        .radius = location.radius,
+    });
+}
+
+void World::addMover(
+    thing::Entity entity,
+    ObjectType type,
+    const WorldLocation& location,
+    const WorldMovement& movement)
+{
+    const auto slot = static_cast<uint32_t>(_movers.size());
+    _movers.push_back(Mover{
+        .entity = entity,
+        .type = type,
+        .proxy = _broadphase.insert(
+            entity, location.position, location.radius, _nextBodyOrder++),
+        .radius = location.radius,
+        .accelerationTime = movement.accelerationTime,
+        .decelerationTime = movement.decelerationTime,
+        .published = {
             .location = location.position,
-            .velocity = movement.velocity});
+            .velocity = movement.velocity,
+        },
+    });
+    _moverSlots.insert(entity, slot);
+
+    _kinematics.resize(slot + 1);
+    _kinematics.positionX[slot] = location.position.x;
+    _kinematics.positionY[slot] = location.position.y;
+    _kinematics.velocityX[slot] = movement.velocity.x;
+    _kinematics.velocityY[slot] = movement.velocity.y;
+    _kinematics.maxSpeed[slot] = movement.maxSpeed;
+    _kinematics.deceleration[slot] =
+        movement.maxSpeed / movement.decelerationTime;
+}
+
+void World::despawn(thing::Entity entity)
+{
+    // A static body goes with the grid of its region, which the caller drops
+    if (_staticBodies.find(entity)) {
+        _staticBodies.erase(entity);
+    } else {
+        removeMover(entity);
+    }
+    _ecs.killEntity(entity);
+    _worldEvents.push(Despawn{.entity = entity});
+}
+
+void World::removeMover(thing::Entity entity)
+{
+    const auto slot = _moverSlots.at(entity);
+    _broadphase.remove(_movers[slot].proxy);
+    if (slot + 1 != _movers.size()) {
+        _movers[slot] = _movers.back();
+        _moverSlots.at(_movers[slot].entity) = slot;
     }
+    _movers.pop_back();
+    _kinematics.swapRemove(slot);
+    _moverSlots.erase(entity);
+}
 
-    // check for collisions with a stupid loop
-    for (auto& movingEntity : _ecs.entities<WorldMovement>()) {
-        auto& movingEntityLocation = _ecs.component<WorldLocation>(movingEntity);
-        for (const auto& someObjectLocation : _ecs.components<WorldLocation>()) {
-            if (&movingEntityLocation == &someObjectLocation) {
-                continue;
+XYVector World::moverPosition(uint32_t slot) const
+{
+    return {_kinematics.positionX[slot], _kinematics.positionY[slot]};
+}
+
+void World::setMoverPosition(uint32_t slot, const XYVector& position)
+{
+    _kinematics.positionX[slot] = position.x;
+    _kinematics.positionY[slot] = position.y;
+}
+
+void World::markMoved(uint32_t slot)
+{
+    auto& mover = _movers[slot];
+    if (!mover.published.dirty) {
+        mover.published.dirty = true;
+        _moved.push_back(mover.entity);
+    }
+}
+
+template <class F>
+void World::forEachAwake(F&& function)
+{
+    if (!_jobs) {
+        for (auto& push : _awake) {
+            function(push);
+        }
+        return;
+    }
+
+    _jobs->parallelFor(
+        _awake.size(), MoversPerJob, [this, &function] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                function(_awake[i]);
             }
+        });
+}
 
-            auto oof = movingEntityLocation.radius +
-                someObjectLocation.radius -
-                length(movingEntityLocation.position -
-                    someObjectLocation.position);
-            if (oof > 0) {
-                movingEntityLocation.position +=
-                    oof * unit(movingEntityLocation.position -
-                        someObjectLocation.position);
+void World::wakeTouched()
+{
+    // A sleeping mover that an awake one runs into is woken up, so that it
+    // is pushed out as well instead of only standing in the way. Woken
+    // movers go into _awake in slot order, like the others.
+    const auto awakeCount = _awake.size();
+    for (size_t i = 0; i < awakeCount; i++) {
+        const auto slot = _awake[i].slot;
+        const auto position = moverPosition(slot);
+        const auto radius = _movers[slot].radius;
+        const auto extent = XYVector{radius, radius};
+        _broadphase.query(
+            position - extent, position + extent, _scratch.dynamics);
+        for (auto proxy : _scratch.dynamics) {
+            const auto other = _moverSlots.at(_broadphase.entity(proxy));
+            auto& mover = _movers[other];
+            if (!mover.awake && length(position - moverPosition(other)) <
+                    radius + mover.radius) {
+                mover.awake = true;
+                _awake.push_back(Push{.slot = other});
             }
         }
     }
+
+    if (_awake.size() > awakeCount) {
+        std::sort(_awake.begin(), _awake.end(), [] (const auto& a, const auto& b) {
+            return a.slot < b.slot;
+        });
+    }
+}
+
+void World::bakeStatics()
+{
+    auto zone = ProfileZone{"World::bakeStatics"};
+
+    for (auto& [coord, bodies] : _unbakedStatics) {
+        auto& grid = _staticGrids[coord];
+        bodies.reserve(bodies.size() + grid.size());
+        for (uint32_t i = 0; i < grid.size(); i++) {
+            bodies.push_back(StaticGrid::Body{
+                .entity = grid.entity(i),
+                .order = grid.order(i),
+                .position = grid.position(i),
+                .radius = grid.radius(i),
+            });
+        }
+        grid = StaticGrid{std::move(bodies), BroadphaseCellSize};
+    }
+    _unbakedStatics.clear();
+}
+
+void World::queryObstacles(
+    const XYVector& min,
+    const XYVector& max,
+    CollisionScratch& scratch) const
+{
+    auto& obstacles = scratch.obstacles;
+    obstacles.clear();
+
+    // Each grid, and the broadphase, lists its bodies in body order, so
+    // only results from several of them need sorting
+    int sources = 0;
+    auto queryGrid = [&] (const RegionCoord& coord) {
+        auto grid = _staticGrids.find(coord);
+        if (grid == _staticGrids.end()) {
+            return;
+        }
+        grid->second.query(min, max, scratch.statics);
+        for (auto index : scratch.statics) {
+            obstacles.push_back(Obstacle{
+                .order = grid->second.order(index),
+                .position = grid->second.position(index),
+                .radius = grid->second.radius(index),
+            });
+        }
+        sources += !scratch.statics.empty();
+    };
+
+    const auto first = gridRegion(min);
+    const auto last = gridRegion(max);
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            queryGrid({x, y});
+        }
+    }
+
+    _broadphase.query(min, max, scratch.dynamics);
+    for (auto proxy : scratch.dynamics) {
+        obstacles.push_back(Obstacle{
+            .order = _broadphase.order(proxy),
+            .position = _broadphase.position(proxy),
+            .radius = _broadphase.radius(proxy),
+        });
+    }
+    sources += !scratch.dynamics.empty();
+
+    if (sources > 1) {
+        std::sort(
+            obstacles.begin(), obstacles.end(),
+            [] (const auto& a, const auto& b) { return a.order < b.order; });
+    }
+}
+
+bool World::pushOut(
+    uint64_t order,
+    XYVector& position,
+    float radius,
+    CollisionScratch& scratch) const
+{
+    // Push the position out of every object it overlaps, in body order, so
+    // pushes are applied in the same order as with a scan over all bodies
+    auto query = [this, &position, radius, &scratch] {
+        auto extent = XYVector{radius, radius};
+        queryObstacles(position - extent, position + extent, scratch);
+    };
+
+    auto& obstacles = scratch.obstacles;
+    bool pushed = false;
+    query();
+    for (size_t i = 0; i < obstacles.size(); i++) {
+        const auto other = obstacles[i];
+        if (other.order == order) {
+            continue;
+        }
+
+        auto oof = radius + other.radius - length(position - other.position);
+        if (oof > 0) {
+            position += oof * unit(position - other.position);
+            pushed = true;
+
+            // Pick up objects that are now in range and come later in order
+            query();
+            std::erase_if(obstacles, [&other] (const auto& o) {
+                return o.order <= other.order;
+            });
+            i = static_cast<size_t>(-1);
+        }
+    }
+    return pushed;
 }
@@ -1,15 +1,34 @@
 #pragma once
 
+#include "entity-map.hpp"
+#include "jobs.hpp"
+#include "kinematics.hpp"
+#include "level.hpp"
+#include "region-store.hpp"
+#include "spatial-hash.hpp"
+#include "static-grid.hpp"
 #include "types.hpp"
 
 #include "evening.hpp"
 #include "thing.hpp"
 
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <set>
+#include <span>
+#include <vector>
+
+class InputRecorder;
+
 struct WorldLocation {
     XYVector position;
     float radius = 0.f;
 };
 
+// Movement parameters of a mover when it is added
 struct WorldMovement {
     XYVector velocity;
     float maxSpeed = 0.f;
@@ -17,20 +36,212 @@ struct WorldMovement {
     float decelerationTime = 0.f;
 };
 
-struct Control {
-    XYVector control;
+// Last state sent to the world channel, and whether the entity may have
+// changed since then
+struct PublishedMove {
+    XYVector location;
+    XYVector velocity;
+    bool dirty = false;
+};
+
+// Objects without movement are static bodies. They are baked into one
+// StaticGrid per region, which is built when the region is loaded. Moving
+// objects are dynamic bodies in the broadphase hash. Both kinds share one
+// body order, which is the order collisions are resolved in.
+//
+// Static bodies are most of a level, and have no components besides these,
+// so they are kept in one packed table instead of the ECS.
+struct StaticBody {
+    uint64_t order = 0;
+    ObjectType type = ObjectType::Tree;
+    WorldLocation location;
+};
+
+// Picks a new random control direction every now and then
+struct Wander {
+    float timeLeft = 0.f;
+};
+
+// Parameters for a generated level with lots of objects in a square area
+struct StressLevel {
+    int obstacles = 1000;
+    int movers = 10;
+    bool randomMovers = true;
+    float obstacleDensity = 0.05f;
+    unsigned seed = 1;
+};
+
+// World space split into square regions. Only regions around the focus (the
+// first controlled object, or the first mover if none is controlled) are
+// resident and simulated; the rest are kept serialized until the focus comes
+// near. Regions are unloaded one region further out than they are loaded, so
+// walking along a border does not reload them over and over.
+struct RegionStreaming {
+    float regionSize = 0.f; // 0 keeps the whole level resident
+    int activeRadius = 2; // regions around the focus region in each direction
 };
 
 class World : public evening::Subscriber {
 public:
     World(evening::Channel& worldEvents, evening::Channel& controlEvents);
 
-    void initTestLevel();
+    // Must be set before the level is loaded
+    void streamRegions(const RegionStreaming& streaming);
+
+    void loadLevel(const LevelView& level);
+    void initStressLevel(const StressLevel& level);
+
+    // The current state of every resident object, in the level file layout
+    LevelData exportLevel();
+
+    size_t residentObjects() const
+    {
+        return _broadphase.size() + _staticBodies.size();
+    }
+    size_t storedRegions() const { return _regionStore.regionCount(); }
+
+    // With more than one thread, movement and collision passes are split
+    // between threads, and collisions are resolved against the state before
+    // the pass instead of one entity after another
+    void setThreads(int threads);
 
     void update(double delta);
 
+    // Push a Move for every entity that has changed since the last publish,
+    // with its latest state, then an InputApplied for every InputStamp that
+    // an update has taken in since
+    void publish();
+
+    // Updates done so far; controls delivered now apply from this tick on
+    uint64_t tick() const { return _tick; }
+
+    // Hash of the state of every moving object
+    uint64_t checksum();
+
+    // Logs control input and a checksum after every tick, until reset to
+    // nullptr. The recorder is used from the thread that updates the world.
+    void record(InputRecorder* recorder);
+
     thing::EntityManager _ecs;
 private:
+    void loadObjects(
+        std::span<const LevelObjectType> types,
+        std::span<const LevelObject> objects,
+        std::span<const LevelMovement> movements);
+    std::vector<thing::Entity> spawnObjects(
+        std::span<const LevelObjectType> types,
+        std::span<const LevelObject> objects,
+        std::span<const LevelMovement> movements);
+    EntityMap<uint32_t> movementFlags();
+    LevelData exportEntities(
+        std::span<const thing::Entity> entities,
+        const EntityMap<uint32_t>& flags);
+    void despawn(thing::Entity entity);
+    void removeMover(thing::Entity entity);
+
+    RegionCoord region(const XYVector& position) const;
+    // The region whose grid holds a static body there; all of them share
+    // one grid without streaming
+    RegionCoord gridRegion(const XYVector& position) const;
+    bool nearFocus(const RegionCoord& region, int radius) const;
+    void updateRegions();
+
+    // Room for this many more bodies of each kind
+    void reserve(size_t statics, size_t movers);
+
+    void addStatic(
+        thing::Entity entity, ObjectType type, const WorldLocation& location);
+    void addMover(
+        thing::Entity entity,
+        ObjectType type,
+        const WorldLocation& location,
+        const WorldMovement& movement);
+
+    // Moving bodies keep their position, velocity and speed limits in
+    // _kinematics for as long as they exist, and everything else in
+    // _movers, at the same slot
+    struct Mover {
+        thing::Entity entity;
+        ObjectType type = ObjectType::Hero;
+        SpatialHash::Handle proxy = 0;
+        float radius = 0.f;
+        float accelerationTime = 0.f;
+        float decelerationTime = 0.f;
+        XYVector control;
+        PublishedMove published;
+        // In _awake this tick
+        bool awake = false;
+        // Pushed by a collision, so it is checked again next tick even if
+        // it has come to rest
+        bool pushed = false;
+    };
+
+    // An awake mover, and where collisions pushed it this tick
+    struct Push {
+        uint32_t slot = 0;
+        bool pushed = false;
+        XYVector position;
+    };
+
+    XYVector moverPosition(uint32_t slot) const;
+    void setMoverPosition(uint32_t slot, const XYVector& position);
+    void markMoved(uint32_t slot);
+
+    template <class F> void forEachAwake(F&& function);
+
+    // Adds sleeping movers that overlap awake ones to _awake
+    void wakeTouched();
+
+    struct Obstacle {
+        uint64_t order = 0;
+        XYVector position;
+        float radius = 0.f;
+    };
+
+    struct CollisionScratch {
+        std::vector<uint32_t> statics;
+        std::vector<SpatialHash::Handle> dynamics;
+        std::vector<Obstacle> obstacles;
+    };
+
+    // Builds the grids of the regions that static bodies were added to
+    void bakeStatics();
+
+    // Static and dynamic bodies overlapping the box, merged in body order
+    void queryObstacles(
+        const XYVector& min,
+        const XYVector& max,
+        CollisionScratch& scratch) const;
+
+    bool pushOut(
+        uint64_t order,
+        XYVector& position,
+        float radius,
+        CollisionScratch& scratch) const;
+
     evening::Channel& _worldEvents;
-    Control* _control = nullptr;
+    std::vector<thing::Entity> _controlled;
+    std::mt19937 _random;
+    SpatialHash _broadphase;
+    EntityMap<StaticBody> _staticBodies;
+    std::map<RegionCoord, StaticGrid> _staticGrids;
+    std::map<RegionCoord, std::vector<StaticGrid::Body>> _unbakedStatics;
+    uint64_t _nextBodyOrder = 0;
+    CollisionScratch _scratch;
+    std::vector<thing::Entity> _moved;
+    Kinematics _kinematics;
+    std::vector<Mover> _movers;
+    EntityMap<uint32_t> _moverSlots;
+    std::vector<Push> _awake;
+    std::unique_ptr<JobPool> _jobs;
+    uint64_t _tick = 0;
+    InputRecorder* _recorder = nullptr;
+    std::vector<uint32_t> _pendingInputs;
+    std::vector<uint32_t> _appliedInputs;
+
+    RegionStreaming _streaming;
+    std::optional<thing::Entity> _focusEntity;
+    RegionCoord _focusRegion;
+    std::set<RegionCoord> _loadedRegions;
+    RegionStore _regionStore;
 };